@@ -0,0 +1,270 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+// Standalone benchmark and correctness check for the color conversion row kernels.
+//
+// The converter is compiled without the engine, using the headers in Shims/. Each kernel
+// that the CPU supports is compared against the scalar kernel for all matrices and ranges,
+// including widths that end in the scalar tail, and then timed on full HD frames.
+//
+// Build and run with: make run
+
+#include "../../Source/VlcMediaPlayer/Private/Player/VlcMediaPlayerColorConverter.cpp"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+
+namespace ColorConverterBenchmark
+{
+	using namespace VlcMediaPlayerColorConverter;
+
+	/** Value that the bytes behind a converted row are filled with. */
+	const uint8 Guard = 0xcd;
+
+	/** Number of guard bytes behind a converted row. */
+	const int32 GuardSize = 64;
+
+	/** A kernel under test. */
+	struct FTestKernel
+	{
+		/** The kernel's row conversion function. */
+		FRowKernel Function;
+
+		/** The kernel's name. */
+		const char* Name;
+	};
+
+	/** A conversion matrix and range. */
+	struct FTestMode
+	{
+		/** The conversion matrix. */
+		EVlcMediaPlayerColorMatrix Matrix;
+
+		/** Whether the input uses full range values. */
+		bool FullRange;
+
+		/** The mode's name. */
+		const char* Name;
+	};
+
+	/** Deterministic pseudo-random byte generator. */
+	struct FRandom
+	{
+		uint32 State = 0x2545f491;
+
+		uint8 Next()
+		{
+			State = State * 1664525u + 1013904223u;
+			return (uint8)(State >> 24);
+		}
+	};
+
+	/** Get the kernels that the CPU supports, excluding the scalar reference. */
+	std::vector<FTestKernel> GetTestKernels()
+	{
+		std::vector<FTestKernel> Kernels;
+
+#if PLATFORM_CPU_X86_FAMILY
+		if (HasSse41InstructionSupport())
+		{
+			Kernels.push_back({ &ConvertRowSse41, "SSE4.1" });
+		}
+
+		if (FPlatformMisc::HasAVX2InstructionSupport())
+		{
+			Kernels.push_back({ &ConvertRowAvx2, "AVX2" });
+		}
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+		Kernels.push_back({ &ConvertRowNeon, "NEON" });
+#endif
+
+		return Kernels;
+	}
+
+	/** Fill the planes of a row with random samples, including the extreme values. */
+	void FillRow(std::vector<uint8>& Y, std::vector<uint8>& Cb, std::vector<uint8>& Cr, FRandom& Random)
+	{
+		static const uint8 Extremes[] = { 0, 16, 235, 240, 255 };
+
+		for (std::vector<uint8>* Plane : { &Y, &Cb, &Cr })
+		{
+			for (size_t Index = 0; Index < Plane->size(); ++Index)
+			{
+				const uint8 Value = Random.Next();
+				(*Plane)[Index] = (Value < 40) ? Extremes[Value % 5] : Value;
+			}
+		}
+	}
+
+	/** Compare a kernel against the scalar kernel, returning the number of mismatching rows. */
+	int32 CheckKernel(const FTestKernel& Kernel, const FTestMode& Mode)
+	{
+		static const int32 LargeWidths[] = { 1279, 1280, 1919, 1920, 3839, 3840 };
+
+		const FVlcMediaPlayerColorCoefficients Coefficients = GetCoefficients(Mode.Matrix, Mode.FullRange);
+
+		std::vector<int32> Widths;
+		{
+			for (int32 Width = 1; Width <= 64; ++Width)
+			{
+				Widths.push_back(Width);
+			}
+
+			Widths.insert(Widths.end(), std::begin(LargeWidths), std::end(LargeWidths));
+		}
+
+		FRandom Random;
+		int32 NumFailures = 0;
+
+		for (int32 Width : Widths)
+		{
+			// offset the rows, so that unaligned loads and stores are covered
+			for (int32 Offset = 0; Offset < 4; ++Offset)
+			{
+				std::vector<uint8> Y(Offset + Width);
+				std::vector<uint8> Cb(Offset + (Width + 1) / 2);
+				std::vector<uint8> Cr(Offset + (Width + 1) / 2);
+				std::vector<uint8> Expected(Offset + Width * 4 + GuardSize, Guard);
+				std::vector<uint8> Actual(Offset + Width * 4 + GuardSize, Guard);
+
+				FillRow(Y, Cb, Cr, Random);
+
+				ConvertRowScalar(Y.data() + Offset, Cb.data() + Offset, Cr.data() + Offset, Expected.data() + Offset, Width, Coefficients);
+				Kernel.Function(Y.data() + Offset, Cb.data() + Offset, Cr.data() + Offset, Actual.data() + Offset, Width, Coefficients);
+
+				if (Actual == Expected)
+				{
+					continue;
+				}
+
+				size_t Index = 0;
+
+				while (Actual[Index] == Expected[Index])
+				{
+					++Index;
+				}
+
+				const size_t Pixel = (Index - Offset) / 4;
+
+				if (Pixel >= (size_t)Width)
+				{
+					printf("  FAIL %s %s: width %i, offset %i wrote past the end of the row\n", Kernel.Name, Mode.Name, Width, Offset);
+				}
+				else
+				{
+					printf("  FAIL %s %s: width %i, offset %i differs at pixel %zu (expected %u, got %u)\n", Kernel.Name, Mode.Name, Width, Offset, Pixel, Expected[Index], Actual[Index]);
+				}
+
+				++NumFailures;
+			}
+		}
+
+		return NumFailures;
+	}
+
+	/** Time a kernel on full HD frames, returning the throughput in megapixels per second. */
+	double TimeKernel(FRowKernel Kernel, const FVlcMediaPlayerColorCoefficients& Coefficients)
+	{
+		const int32 Width = 1920;
+		const int32 Height = 1080;
+		const int32 NumFrames = 20;
+		const int32 NumRuns = 5;
+
+		std::vector<uint8> Y(Width * Height);
+		std::vector<uint8> Cb((Width / 2) * (Height / 2));
+		std::vector<uint8> Cr((Width / 2) * (Height / 2));
+		std::vector<uint8> Dest(Width * Height * 4);
+
+		FRandom Random;
+		FillRow(Y, Cb, Cr, Random);
+
+		double BestSeconds = 0.0;
+
+		// the fastest run is the least disturbed by other processes
+		for (int32 Run = 0; Run < NumRuns; ++Run)
+		{
+			const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+
+			for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+			{
+				for (int32 Row = 0; Row < Height; ++Row)
+				{
+					Kernel(
+						Y.data() + Row * Width,
+						Cb.data() + (Row / 2) * (Width / 2),
+						Cr.data() + (Row / 2) * (Width / 2),
+						Dest.data() + Row * Width * 4,
+						Width,
+						Coefficients
+					);
+				}
+			}
+
+			const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+			if ((Run == 0) || (Seconds < BestSeconds))
+			{
+				BestSeconds = Seconds;
+			}
+		}
+
+		// keep the conversion from being optimized away
+		volatile uint8 Sink = Dest[Dest.size() / 2];
+		(void)Sink;
+
+		return (double)Width * Height * NumFrames / BestSeconds / 1000000.0;
+	}
+}
+
+
+int main()
+{
+	using namespace ColorConverterBenchmark;
+
+	const FTestMode Modes[] =
+	{
+		{ EVlcMediaPlayerColorMatrix::Bt601, false, "BT.601 limited" },
+		{ EVlcMediaPlayerColorMatrix::Bt601, true, "BT.601 full" },
+		{ EVlcMediaPlayerColorMatrix::Bt709, false, "BT.709 limited" },
+		{ EVlcMediaPlayerColorMatrix::Bt709, true, "BT.709 full" },
+	};
+
+	const std::vector<FTestKernel> Kernels = GetTestKernels();
+
+	printf("Selected kernel: %s\n\n", FVlcMediaPlayerColorConverter::GetKernelName());
+	printf("Correctness (against Scalar):\n");
+
+	int32 NumFailures = 0;
+
+	for (const FTestKernel& Kernel : Kernels)
+	{
+		for (const FTestMode& Mode : Modes)
+		{
+			const int32 NumKernelFailures = CheckKernel(Kernel, Mode);
+			printf("  %-8s %-16s %s\n", Kernel.Name, Mode.Name, (NumKernelFailures == 0) ? "ok" : "FAILED");
+
+			NumFailures += NumKernelFailures;
+		}
+	}
+
+	if (Kernels.empty())
+	{
+		printf("  no SIMD kernels are supported on this CPU\n");
+	}
+
+	printf("\nThroughput (1920x1080, single thread):\n");
+
+	const FVlcMediaPlayerColorCoefficients Coefficients = GetCoefficients(EVlcMediaPlayerColorMatrix::Bt709, false);
+	const double ScalarRate = TimeKernel(&ConvertRowScalar, Coefficients);
+
+	printf("  %-8s %8.1f MPixels/s\n", "Scalar", ScalarRate);
+
+	for (const FTestKernel& Kernel : Kernels)
+	{
+		const double Rate = TimeKernel(Kernel.Function, Coefficients);
+		printf("  %-8s %8.1f MPixels/s (%.1fx)\n", Kernel.Name, Rate, Rate / ScalarRate);
+	}
+
+	return (NumFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,15 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+/** Runs the body serially (the benchmark measures single-threaded throughput). */
+template<typename BodyType>
+void ParallelFor(int32 Num, BodyType Body)
+{
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		Body(Index);
+	}
+}
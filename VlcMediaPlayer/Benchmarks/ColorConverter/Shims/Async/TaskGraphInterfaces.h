@@ -0,0 +1,26 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+class FTaskGraphInterface
+{
+public:
+
+	static FTaskGraphInterface& Get()
+	{
+		static FTaskGraphInterface TaskGraph;
+		return TaskGraph;
+	}
+
+	static bool IsRunning()
+	{
+		return false;
+	}
+
+	int32 GetNumWorkerThreads() const
+	{
+		return 0;
+	}
+};
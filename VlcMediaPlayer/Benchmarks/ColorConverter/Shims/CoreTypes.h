@@ -0,0 +1,35 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+// Minimal stand-in for the engine header, so that the color converter compiles without the engine.
+
+#pragma once
+
+#include <cstdint>
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+
+typedef char TCHAR;
+
+#define TEXT(x) x
+#define FORCEINLINE inline __attribute__((always_inline))
+
+#if defined(__x86_64__) || defined(__i386__)
+	#define PLATFORM_CPU_X86_FAMILY 1
+	#define PLATFORM_CPU_ARM_FAMILY 0
+#elif defined(__aarch64__) || defined(__arm__)
+	#define PLATFORM_CPU_X86_FAMILY 0
+	#define PLATFORM_CPU_ARM_FAMILY 1
+#else
+	#define PLATFORM_CPU_X86_FAMILY 0
+	#define PLATFORM_CPU_ARM_FAMILY 0
+#endif
+
+#define PLATFORM_ALWAYS_HAS_SSE4_1 0
+#define PLATFORM_ENABLE_VECTORINTRINSICS_NEON PLATFORM_CPU_ARM_FAMILY
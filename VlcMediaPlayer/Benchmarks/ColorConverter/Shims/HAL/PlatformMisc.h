@@ -0,0 +1,17 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+struct FPlatformMisc
+{
+	static bool HasAVX2InstructionSupport()
+	{
+#if PLATFORM_CPU_X86_FAMILY
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+};
@@ -0,0 +1,15 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+#include <cstring>
+
+struct FMemory
+{
+	static FORCEINLINE void* Memcpy(void* Dest, const void* Src, size_t Count)
+	{
+		return memcpy(Dest, Src, Count);
+	}
+};
@@ -0,0 +1,11 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+struct FIntPoint
+{
+	int32 X;
+	int32 Y;
+};
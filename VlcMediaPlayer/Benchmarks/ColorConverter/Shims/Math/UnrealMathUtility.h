@@ -0,0 +1,26 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+struct FMath
+{
+	template<typename T>
+	static T Clamp(T Value, T Min, T Max)
+	{
+		return (Value < Min) ? Min : (Value < Max) ? Value : Max;
+	}
+
+	template<typename T>
+	static T Max(T A, T B)
+	{
+		return (A >= B) ? A : B;
+	}
+
+	template<typename T>
+	static T Min(T A, T B)
+	{
+		return (A <= B) ? A : B;
+	}
+};
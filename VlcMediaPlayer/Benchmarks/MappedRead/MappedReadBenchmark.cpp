@@ -0,0 +1,469 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+// Standalone benchmark that compares the two ways the player reads local media files.
+//
+// The mapped path mirrors FVlcMediaPlayerSource::HandleMappedMediaRead: the whole file is
+// mapped and marked sequential, and once reads continue past a seek, a window ahead of the
+// read position is paged in with MADV_WILLNEED before the data is copied into VLC's buffer. The archive path mirrors the
+// engine's buffered file reader archive (FArchiveFileReaderGeneric with its default 64 KB
+// buffer), which the player used for all local files before.
+//
+// Each access pattern is read through both paths, once after dropping the file from the page
+// cache (cold) and then with the file cached (warm, fastest of several runs). The bytes read
+// are checksummed, so that both paths are also checked against each other.
+//
+// Build and run with: make run
+// Options: MappedReadBenchmark [file size in MB (default 1024)] [directory (default /tmp)]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+namespace MappedReadBenchmark
+{
+	/** Size of the engine's file reader archive buffer (PLATFORM_FILE_READER_BUFFER_SIZE). */
+	const int64_t ArchiveBufferSize = 64 * 1024;
+
+	/** Amount of mapped data ahead of the read position that is paged in (as in the player). */
+	const uint64_t MappedReadAhead = 8 * 1024 * 1024;
+
+	/** Number of warm runs, of which the fastest is reported. */
+	const int NumWarmRuns = 3;
+
+	/** An access pattern, i.e. how VLC reads the file. */
+	struct FPattern
+	{
+		/** The pattern's name. */
+		const char* Name;
+
+		/** Number of bytes per read. */
+		int64_t ReadSize;
+
+		/** Number of reads between seeks to a random position (0 = sequential). */
+		int ReadsPerSeek;
+	};
+
+	/** Deterministic pseudo-random number generator. */
+	struct FRandom
+	{
+		uint64_t State = 0x2545f4914f6cdd1d;
+
+		uint64_t Next()
+		{
+			State ^= State << 13;
+			State ^= State >> 7;
+			State ^= State << 17;
+			return State;
+		}
+	};
+
+	/** A file reader that buffers reads like the engine's file reader archive. */
+	class FBufferedArchive
+	{
+	public:
+
+		explicit FBufferedArchive(int InHandle, int64_t InSize)
+			: Buffer(ArchiveBufferSize)
+			, BufferBase(0)
+			, BufferCount(0)
+			, Handle(InHandle)
+			, Pos(0)
+			, Size(InSize)
+		{ }
+
+		void Seek(int64_t InPos)
+		{
+			Pos = InPos;
+		}
+
+		void Serialize(uint8_t* Data, int64_t Length)
+		{
+			while (Length > 0)
+			{
+				// serve what the buffer holds
+				if ((Pos >= BufferBase) && (Pos < BufferBase + BufferCount))
+				{
+					const int64_t Copy = std::min(Length, BufferBase + BufferCount - Pos);
+					memcpy(Data, Buffer.data() + (Pos - BufferBase), Copy);
+
+					Data += Copy;
+					Length -= Copy;
+					Pos += Copy;
+
+					continue;
+				}
+
+				// large reads bypass the buffer
+				if (Length >= ArchiveBufferSize)
+				{
+					const ssize_t Read = pread(Handle, Data, Length, Pos);
+
+					if (Read <= 0)
+					{
+						return;
+					}
+
+					Data += Read;
+					Length -= Read;
+					Pos += Read;
+
+					continue;
+				}
+
+				const ssize_t Read = pread(Handle, Buffer.data(), std::min(ArchiveBufferSize, Size - Pos), Pos);
+
+				if (Read <= 0)
+				{
+					return;
+				}
+
+				BufferBase = Pos;
+				BufferCount = Read;
+			}
+		}
+
+	private:
+
+		/** The read buffer. */
+		std::vector<uint8_t> Buffer;
+
+		/** File offset of the buffered data. */
+		int64_t BufferBase;
+
+		/** Number of buffered bytes. */
+		int64_t BufferCount;
+
+		/** The file handle. */
+		int Handle;
+
+		/** Current read position. */
+		int64_t Pos;
+
+		/** Size of the file. */
+		int64_t Size;
+	};
+
+	/** A file reader that copies from a mapping like the player's mapped file source. */
+	class FMappedReader
+	{
+	public:
+
+		FMappedReader(const uint8_t* InPtr, uint64_t InSize)
+			: AdvisedEnd(0)
+			, MappedPtr(InPtr)
+			, MappedSize(InSize)
+			, Position(0)
+			, SequentialStart(0)
+		{
+			madvise((void*)MappedPtr, MappedSize, MADV_SEQUENTIAL);
+		}
+
+		void Seek(uint64_t Offset)
+		{
+			AdvisedEnd = Offset;
+			Position = Offset;
+			SequentialStart = Offset;
+		}
+
+		void Read(uint8_t* Buffer, uint64_t Length)
+		{
+			const uint64_t BytesToRead = std::min(Length, MappedSize - Position);
+			const uint64_t Window = std::min(Position - SequentialStart, MappedReadAhead);
+
+			if ((Window > 0) && (Position + Window / 2 >= AdvisedEnd))
+			{
+				const uint64_t AdviseStart = std::max(Position, AdvisedEnd);
+				const uint64_t AdviseEnd = std::min(Position + Window, MappedSize);
+
+				if (AdviseEnd > AdviseStart)
+				{
+					const uintptr_t PageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+					const uintptr_t Start = (uintptr_t)(MappedPtr + AdviseStart) & ~(PageSize - 1);
+
+					madvise((void*)Start, (AdviseEnd - AdviseStart) + ((uintptr_t)(MappedPtr + AdviseStart) - Start), MADV_WILLNEED);
+				}
+
+				AdvisedEnd = AdviseEnd;
+			}
+
+			memcpy(Buffer, MappedPtr + Position, BytesToRead);
+			Position += BytesToRead;
+		}
+
+	private:
+
+		/** End of the range that the OS was last asked to page in. */
+		uint64_t AdvisedEnd;
+
+		/** The mapped file. */
+		const uint8_t* MappedPtr;
+
+		/** Size of the mapped file. */
+		uint64_t MappedSize;
+
+		/** Current read position. */
+		uint64_t Position;
+
+		/** Position of the last seek. */
+		uint64_t SequentialStart;
+	};
+
+	/** The result of reading a file once. */
+	struct FResult
+	{
+		/** Sum over the bytes read (to compare the paths and keep the copies alive). */
+		uint64_t Checksum = 0;
+
+		/** Number of bytes read. */
+		int64_t BytesRead = 0;
+
+		/** Time that the reads took. */
+		double Seconds = 0.0;
+	};
+
+	/** Get the read positions of an access pattern, covering about the whole file. */
+	std::vector<int64_t> GetReadPositions(const FPattern& Pattern, int64_t FileSize)
+	{
+		const int64_t NumReads = FileSize / Pattern.ReadSize;
+
+		std::vector<int64_t> Positions;
+		Positions.reserve(NumReads);
+
+		FRandom Random;
+		int64_t Position = 0;
+
+		for (int64_t Index = 0; Index < NumReads; ++Index)
+		{
+			if ((Pattern.ReadsPerSeek > 0) && ((Index % Pattern.ReadsPerSeek) == 0))
+			{
+				Position = (int64_t)(Random.Next() % (uint64_t)(FileSize - Pattern.ReadSize * Pattern.ReadsPerSeek));
+			}
+
+			Positions.push_back(Position);
+			Position += Pattern.ReadSize;
+		}
+
+		return Positions;
+	}
+
+	/** Sum up a buffer that was just read. */
+	uint64_t Sum(const std::vector<uint8_t>& Buffer)
+	{
+		uint64_t Result = 0;
+
+		for (size_t Index = 0; Index < Buffer.size(); Index += 512)
+		{
+			Result += Buffer[Index];
+		}
+
+		return Result;
+	}
+
+	/** Read the file through the buffered archive path. */
+	FResult ReadArchive(const std::string& Path, int64_t FileSize, const FPattern& Pattern, const std::vector<int64_t>& Positions)
+	{
+		FResult Result;
+		std::vector<uint8_t> Buffer(Pattern.ReadSize);
+
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		{
+			const int Handle = open(Path.c_str(), O_RDONLY);
+			FBufferedArchive Archive(Handle, FileSize);
+
+			for (int64_t Position : Positions)
+			{
+				Archive.Seek(Position);
+				Archive.Serialize(Buffer.data(), Pattern.ReadSize);
+
+				Result.Checksum += Sum(Buffer);
+				Result.BytesRead += Pattern.ReadSize;
+			}
+
+			close(Handle);
+		}
+		Result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+		return Result;
+	}
+
+	/** Read the file through the mapped path (including the time to map it). */
+	FResult ReadMapped(const std::string& Path, int64_t FileSize, const FPattern& Pattern, const std::vector<int64_t>& Positions)
+	{
+		FResult Result;
+		std::vector<uint8_t> Buffer(Pattern.ReadSize);
+
+		const std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+		{
+			const int Handle = open(Path.c_str(), O_RDONLY);
+			void* MappedPtr = mmap(nullptr, FileSize, PROT_READ, MAP_PRIVATE, Handle, 0);
+
+			if (MappedPtr == MAP_FAILED)
+			{
+				perror("mmap");
+				exit(1);
+			}
+
+			FMappedReader Reader((const uint8_t*)MappedPtr, FileSize);
+			int64_t NextPosition = 0;
+
+			for (int64_t Position : Positions)
+			{
+				if (Position != NextPosition)
+				{
+					Reader.Seek(Position);
+				}
+
+				Reader.Read(Buffer.data(), Pattern.ReadSize);
+				NextPosition = Position + Pattern.ReadSize;
+
+				Result.Checksum += Sum(Buffer);
+				Result.BytesRead += Pattern.ReadSize;
+			}
+
+			munmap(MappedPtr, FileSize);
+			close(Handle);
+		}
+		Result.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+		return Result;
+	}
+
+	/** Drop the file from the page cache, so that the next read comes from the disk. */
+	void DropFromPageCache(const std::string& Path)
+	{
+		const int Handle = open(Path.c_str(), O_RDONLY);
+
+		fdatasync(Handle);
+		posix_fadvise(Handle, 0, 0, POSIX_FADV_DONTNEED);
+		close(Handle);
+	}
+
+	/** Create the test file, filled with pseudo-random data. */
+	bool CreateFile(const std::string& Path, int64_t FileSize)
+	{
+		const int Handle = open(Path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+
+		if (Handle < 0)
+		{
+			return false;
+		}
+
+		std::vector<uint64_t> Block(1024 * 1024 / sizeof(uint64_t));
+		FRandom Random;
+
+		for (int64_t Written = 0; Written < FileSize; Written += Block.size() * sizeof(uint64_t))
+		{
+			for (uint64_t& Value : Block)
+			{
+				Value = Random.Next();
+			}
+
+			if (write(Handle, Block.data(), Block.size() * sizeof(uint64_t)) < 0)
+			{
+				close(Handle);
+				return false;
+			}
+		}
+
+		close(Handle);
+
+		return true;
+	}
+
+	/** Get the throughput of a result in megabytes per second. */
+	double GetThroughput(const FResult& Result)
+	{
+		return Result.BytesRead / (1024.0 * 1024.0) / Result.Seconds;
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	using namespace MappedReadBenchmark;
+
+	const int64_t FileSize = ((argc > 1) ? atoll(argv[1]) : 1024) * 1024 * 1024;
+	const std::string Path = std::string((argc > 2) ? argv[2] : "/tmp") + "/MappedReadBenchmark.bin";
+
+	const FPattern Patterns[] =
+	{
+		{ "sequential 4 KB", 4 * 1024, 0 },
+		{ "sequential 32 KB", 32 * 1024, 0 },
+		{ "sequential 1 MB", 1024 * 1024, 0 },
+		{ "random 64 KB x 16", 64 * 1024, 16 },
+		{ "random 4 KB x 1", 4 * 1024, 1 },
+	};
+
+	if (FileSize <= 0)
+	{
+		printf("Invalid file size\n");
+		return 1;
+	}
+
+	printf("Creating %lli MB test file %s\n", (long long)(FileSize / (1024 * 1024)), Path.c_str());
+
+	if (!CreateFile(Path, FileSize))
+	{
+		perror("Failed to create the test file");
+		return 1;
+	}
+
+	printf("\n%-20s %12s %12s %12s %12s\n", "Pattern", "Archive", "Mapped", "Archive", "Mapped");
+	printf("%-20s %12s %12s %12s %12s\n", "", "cold MB/s", "cold MB/s", "warm MB/s", "warm MB/s");
+
+	int NumFailures = 0;
+
+	for (const FPattern& Pattern : Patterns)
+	{
+		const std::vector<int64_t> Positions = GetReadPositions(Pattern, FileSize);
+
+		DropFromPageCache(Path);
+		const FResult ArchiveCold = ReadArchive(Path, FileSize, Pattern, Positions);
+
+		DropFromPageCache(Path);
+		const FResult MappedCold = ReadMapped(Path, FileSize, Pattern, Positions);
+
+		FResult ArchiveWarm;
+		FResult MappedWarm;
+
+		for (int Run = 0; Run < NumWarmRuns; ++Run)
+		{
+			const FResult Archive = ReadArchive(Path, FileSize, Pattern, Positions);
+			const FResult Mapped = ReadMapped(Path, FileSize, Pattern, Positions);
+
+			if ((Run == 0) || (Archive.Seconds < ArchiveWarm.Seconds))
+			{
+				ArchiveWarm = Archive;
+			}
+
+			if ((Run == 0) || (Mapped.Seconds < MappedWarm.Seconds))
+			{
+				MappedWarm = Mapped;
+			}
+		}
+
+		printf("%-20s %12.1f %12.1f %12.1f %12.1f", Pattern.Name, GetThroughput(ArchiveCold), GetThroughput(MappedCold), GetThroughput(ArchiveWarm), GetThroughput(MappedWarm));
+
+		if ((ArchiveCold.Checksum != MappedCold.Checksum) || (ArchiveWarm.Checksum != MappedWarm.Checksum) || (ArchiveCold.Checksum != ArchiveWarm.Checksum))
+		{
+			printf("  FAIL: the paths read different data");
+			++NumFailures;
+		}
+
+		printf("\n");
+	}
+
+	unlink(Path.c_str());
+
+	return (NumFailures == 0) ? 0 : 1;
+}
@@ -5,26 +5,112 @@
 
 #include "IMediaEventSink.h"
 #include "IMediaOptions.h"
-#include "Misc/FileHelper.h"
-#include "Serialization/ArrayReader.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/Class.h"
+
+#include "VlcMediaPlayerChunkCache.h"
+#include "VlcMediaPlayerReaper.h"
+
+
+/* Local helpers
+ *****************************************************************************/
+
+namespace VlcMediaPlayer
+{
+	/** Time after which a player that was closed and not reused is released (in seconds). */
+	const double IdlePlayerTimeout = 5.0;
+
+	/** Smallest backwards jump of the reported time that is recognized as a loop (in milliseconds). */
+	const int64 MinLoopJump = 100;
+
+	/** Time after which a pending seek is considered applied, even if VLC didn't report a time near its target (in seconds). */
+	const double SeekTimeout = 1.0;
+
+	/** Events of the VLC player that are handled by StaticEventCallback. */
+	const libvlc_event_e PlayerEvents[] =
+	{
+		libvlc_event_e::libvlc_MediaPlayerEndReached,
+		libvlc_event_e::libvlc_MediaPlayerPlaying,
+		libvlc_event_e::libvlc_MediaPlayerStopped,
+		libvlc_event_e::libvlc_MediaMetaChanged,
+		libvlc_event_e::libvlc_MediaPlayerBuffering,
+		libvlc_event_e::libvlc_MediaPlayerOpening,
+		libvlc_event_e::libvlc_MediaPlayerPaused,
+		libvlc_event_e::libvlc_MediaPlayerEncounteredError,
+		libvlc_event_e::libvlc_MediaPlayerPausableChanged,
+		libvlc_event_e::libvlc_MediaPlayerSeekableChanged,
+		libvlc_event_e::libvlc_MediaPlayerTimeChanged,
+		libvlc_event_e::libvlc_MediaPlayerESAdded,
+		libvlc_event_e::libvlc_MediaPlayerESDeleted,
+		libvlc_event_e::libvlc_MediaPlayerESSelected,
+		libvlc_event_e::libvlc_MediaPlayerVout,
+	};
+
+	/**
+	 * Check whether a time reported by VLC was reported after a pending seek was applied.
+	 *
+	 * VLC may still report times from before the seek after it was requested. Those are
+	 * close to the time at which the seek was requested, while times after the seek are
+	 * closer to its target, even if the seek landed on an earlier key frame.
+	 */
+	bool IsPastSeek(int64 Time, int64 Target, int64 Origin, double PendingTime)
+	{
+		return (FMath::Abs(Time - Target) < FMath::Abs(Time - Origin)) || (PendingTime >= SeekTimeout);
+	}
+}
 
 
 /* FVlcMediaPlayer structors
  *****************************************************************************/
 
 FVlcMediaPlayer::FVlcMediaPlayer(IMediaEventSink& InEventSink, libvlc_instance_t* InVlcInstance)
-	: CurrentRate(0.0f)
-	, CurrentTime(FTimespan::Zero())
+	: AppliedSeekGeneration(0)
+	, AwaitingFirstFrame(false)
+	, BufferFill(100.0f)
+	, CachedPausable(false)
+	, CachedSeekable(false)
+	, CachedState(libvlc_state_t::libvlc_NothingSpecial)
+	, CachedTime(-1)
+	, Callbacks(MakeShared<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe>())
+	, CompletedLoops(0)
+	, CompletedSeekGeneration(0)
+	, CurrentRate(0.0f)
 	, EventSink(InEventSink)
-	, MediaSource(InVlcInstance)
+	, HandOverPending(false)
+	, IdlePlayer(nullptr)
+	, IdleSince(0.0)
+	, InputRepeats(false)
+	, LastFirstFrameTime(0.0)
+	, LastSwitchTime(0.0)
+	, NumFirstFrames(0)
+	, NumLateHandovers(0)
+	, NumLoops(0)
+	, NumMediaSwitches(0)
+	, NumPreloadedHandovers(0)
+	, OpenProgress(0.0f)
+	, OpenStartTime(0.0)
+	, PlaybackRate(1.0f)
 	, Player(nullptr)
+	, PrecacheProgress(1.0f)
+	, PreloadPaused(false)
+	, PreloadPlayer(nullptr)
+	, PreloadStepped(false)
+	, SeekGeneration(0)
+	, SeekOrigin(0)
+	, SeekStartTime(0.0)
+	, SeekTarget(-1)
 	, ShouldLoop(false)
+	, TotalFirstFrameTime(0.0)
+	, TotalSwitchTime(0.0)
+	, VlcInstance(InVlcInstance)
 { }
 
 
 FVlcMediaPlayer::~FVlcMediaPlayer()
 {
 	Close();
+	ReapIdlePlayer();
 }
 
 
@@ -40,17 +126,17 @@ bool FVlcMediaPlayer::CanControl(EMediaControl Control) const
 
 	if (Control == EMediaControl::Pause)
 	{
-		return (libvlc_media_player_can_pause(Player) != 0);
+		return CachedPausable.load();
 	}
 
 	if (Control == EMediaControl::Resume)
 	{
-		return (libvlc_media_player_get_state(Player) != libvlc_state_t::libvlc_Playing);
+		return (CachedState.load() != libvlc_state_t::libvlc_Playing);
 	}
 
 	if ((Control == EMediaControl::Scrub) || (Control == EMediaControl::Seek))
 	{
-		return (libvlc_media_player_is_seekable(Player) != 0);
+		return CachedSeekable.load();
 	}
 
 	return false;
@@ -59,7 +145,7 @@ bool FVlcMediaPlayer::CanControl(EMediaControl Control) const
 
 FTimespan FVlcMediaPlayer::GetDuration() const
 {
-	return MediaSource.GetDuration();
+	return MediaSource.IsValid() ? MediaSource->GetDuration() : FTimespan::Zero();
 }
 
 
@@ -71,14 +157,17 @@ float FVlcMediaPlayer::GetRate() const
 
 EMediaState FVlcMediaPlayer::GetState() const
 {
+	if (OpenTask.IsValid())
+	{
+		return EMediaState::Preparing;
+	}
+
 	if (Player == nullptr)
 	{
 		return EMediaState::Closed;
 	}
 
-	libvlc_state_t State = libvlc_media_player_get_state(Player);
-
-	switch (State)
+	switch (CachedState.load())
 	{
 	case libvlc_state_t::libvlc_Error:
 		return EMediaState::Error;
@@ -105,7 +194,12 @@ EMediaState FVlcMediaPlayer::GetState() const
 
 EMediaStatus FVlcMediaPlayer::GetStatus() const
 {
-	return (GetState() == EMediaState::Preparing) ? EMediaStatus::Buffering : EMediaStatus::None;
+	if ((GetState() == EMediaState::Preparing) || (BufferFill < 100.0f))
+	{
+		return EMediaStatus::Buffering;
+	}
+
+	return EMediaStatus::None;
 }
 
 
@@ -128,7 +222,7 @@ TRangeSet<float> FVlcMediaPlayer::GetSupportedRates(EMediaRateThinning Thinning)
 
 FTimespan FVlcMediaPlayer::GetTime() const
 {
-	return CurrentTime;
+	return Clock.GetTime();
 }
 
 
@@ -140,19 +234,32 @@ bool FVlcMediaPlayer::IsLooping() const
 
 bool FVlcMediaPlayer::Seek(const FTimespan& Time)
 {
-	libvlc_state_t State = libvlc_media_player_get_state(Player);
+	const libvlc_state_t State = CachedState.load();
 
-	if ((State == libvlc_state_t::libvlc_Opening) ||
+	if ((Player == nullptr) ||
+		(State == libvlc_state_t::libvlc_Opening) ||
 		(State == libvlc_state_t::libvlc_Buffering) ||
 		(State == libvlc_state_t::libvlc_Error))
 	{
 		return false;
 	}
 
-	if (Time != CurrentTime)
+	if (Time != Clock.GetTime())
 	{
+		// the seek is pending until VLC reports a time near its target, and earlier times are ignored
+		{
+			FScopeLock Lock(&SeekCriticalSection);
+
+			CachedTime = -1;
+			SeekOrigin = (int64)Clock.GetTime().GetTotalMilliseconds();
+			SeekStartTime = FPlatformTime::Seconds();
+			SeekTarget = (int64)Time.GetTotalMilliseconds();
+
+			++SeekGeneration;
+		}
+
 		libvlc_media_player_set_time(Player, Time.GetTotalMilliseconds());
-		CurrentTime = Time;
+		Clock.Reset(Time);
 	}
 
 	return true;
@@ -161,7 +268,13 @@ bool FVlcMediaPlayer::Seek(const FTimespan& Time)
 
 bool FVlcMediaPlayer::SetLooping(bool Looping)
 {
+	if ((Looping != ShouldLoop) && MediaSource.IsValid())
+	{
+		SetInputRepeat(Looping);
+	}
+
 	ShouldLoop = Looping;
+
 	return true;
 }
 
@@ -178,11 +291,13 @@ bool FVlcMediaPlayer::SetRate(float Rate)
 		return false;
 	}
 
+	const libvlc_state_t State = CachedState.load();
+
 	if (FMath::IsNearlyZero(Rate))
 	{
-		if (libvlc_media_player_get_state(Player) == libvlc_state_t::libvlc_Playing)
+		if (State == libvlc_state_t::libvlc_Playing)
 		{
-			if (libvlc_media_player_can_pause(Player) == 0)
+			if (!CachedPausable.load())
 			{
 				return false;
 			}
@@ -190,11 +305,22 @@ bool FVlcMediaPlayer::SetRate(float Rate)
 			libvlc_media_player_pause(Player);
 		}
 	}
-	else if (libvlc_media_player_get_state(Player) != libvlc_state_t::libvlc_Playing)
+	else
 	{
-		if (libvlc_media_player_play(Player) == -1)
+		PlaybackRate = Rate;
+
+		if (State != libvlc_state_t::libvlc_Playing)
 		{
-			return false;
+			// resuming keeps the current input, otherwise a new one is started
+			if (State != libvlc_state_t::libvlc_Paused)
+			{
+				InputRepeats = ShouldLoop;
+			}
+
+			if (libvlc_media_player_play(Player) == -1)
+			{
+				return false;
+			}
 		}
 	}
 
@@ -207,25 +333,57 @@ bool FVlcMediaPlayer::SetRate(float Rate)
 
 void FVlcMediaPlayer::Close()
 {
+	if (OpenTask.IsValid())
+	{
+		OpenTask->Cancel();
+
+		// a reused player was handed to the reaper together with the callbacks
+		if (OpenTask->IsReusingPlayer())
+		{
+			Callbacks = MakeShared<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe>();
+		}
+
+		OpenTask.Reset();
+	}
+
+	AwaitingFirstFrame = false;
+	DiscardPreload();
+
 	if (Player == nullptr)
 	{
 		return;
 	}
 
-	// detach callback handlers
-	Callbacks.Shutdown();
+	DetachEvents();
 	Tracks.Shutdown();
 	View.Shutdown();
 
-	// release player
-	libvlc_media_player_stop(Player);
-	libvlc_media_player_release(Player);
+	Callbacks->FlushSamples();
+
+	// keep a paused player for the next Open, or stop & release it in the background
+	if (CachedPausable.load())
+	{
+		libvlc_media_player_set_pause(Player, 1);
+
+		IdlePlayer = Player;
+		IdleSince = FPlatformTime::Seconds();
+		IdleSource = MediaSource;
+	}
+	else
+	{
+		FVlcMediaPlayerReaper::Get().Reap(Player, MediaSource, Callbacks);
+		Callbacks = MakeShared<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe>();
+	}
+
 	Player = nullptr;
 
 	// reset fields
+	Clock = FVlcMediaPlayerClock();
 	CurrentRate = 0.0f;
-	CurrentTime = FTimespan::Zero();
-	MediaSource.Close();
+	Events.Empty();
+	ResetCachedState();
+	MediaSource.Reset();
+	OpenProgress = 0.0f;
 	Info.Empty();
 
 	// notify listeners
@@ -267,13 +425,13 @@ FGuid FVlcMediaPlayer::GetPlayerPluginGUID() const
 
 IMediaSamples& FVlcMediaPlayer::GetSamples()
 {
-	return Callbacks.GetSamples();
+	return Callbacks->GetSamples();
 }
 
 
 FString FVlcMediaPlayer::GetStats() const
 {
-	libvlc_media_t* Media = MediaSource.GetMedia();
+	libvlc_media_t* Media = MediaSource.IsValid() ? MediaSource->GetMedia() : nullptr;
 
 	if (Media == nullptr)
 	{
@@ -315,6 +473,30 @@ FString FVlcMediaPlayer::GetStats() const
 		StatsString += FString::Printf(TEXT("    Sent Bytes: %i\n"), Stats.i_sent_bytes);
 		StatsString += FString::Printf(TEXT("    Sent Packets: %i\n"), Stats.i_sent_packets);
 		StatsString += TEXT("\n");
+
+		StatsString += TEXT("Opening\n");
+		StatsString += FString::Printf(TEXT("    Opens: %i\n"), NumFirstFrames);
+		StatsString += FString::Printf(TEXT("    Last Open To First Frame: %.1f ms\n"), LastFirstFrameTime * 1000.0);
+		StatsString += FString::Printf(TEXT("    Average Open To First Frame: %.1f ms\n"), (NumFirstFrames > 0) ? TotalFirstFrameTime * 1000.0 / NumFirstFrames : 0.0);
+		StatsString += TEXT("\n");
+
+		StatsString += TEXT("Media Switching\n");
+		StatsString += FString::Printf(TEXT("    Switches: %i\n"), NumMediaSwitches);
+		StatsString += FString::Printf(TEXT("    Last Switch Time: %.1f ms\n"), LastSwitchTime * 1000.0);
+		StatsString += FString::Printf(TEXT("    Average Switch Time: %.1f ms\n"), (NumMediaSwitches > 0) ? TotalSwitchTime * 1000.0 / NumMediaSwitches : 0.0);
+		StatsString += TEXT("\n");
+
+		StatsString += TEXT("Playlist\n");
+		StatsString += FString::Printf(TEXT("    Queued Items: %i\n"), Playlist.Num());
+		StatsString += FString::Printf(TEXT("    Preloaded Handovers: %i\n"), NumPreloadedHandovers);
+		StatsString += FString::Printf(TEXT("    Late Handovers: %i\n"), NumLateHandovers);
+		StatsString += TEXT("\n");
+
+		StatsString += MediaSource->GetStats();
+		StatsString += Callbacks->GetStats();
+		StatsString += Clock.GetStats();
+		StatsString += FVlcMediaPlayerChunkCache::Get().GetStats();
+		StatsString += FVlcMediaPlayerReaper::Get().GetStats();
 	}
 
 	return StatsString;
@@ -329,7 +511,12 @@ IMediaTracks& FVlcMediaPlayer::GetTracks()
 
 FString FVlcMediaPlayer::GetUrl() const
 {
-	return MediaSource.GetCurrentUrl();
+	if (OpenTask.IsValid())
+	{
+		return OpenTask->GetUrl();
+	}
+
+	return MediaSource.IsValid() ? MediaSource->GetCurrentUrl() : FString();
 }
 
 
@@ -348,88 +535,68 @@ bool FVlcMediaPlayer::Open(const FString& Url, const IMediaOptions* Options)
 		return false;
 	}
 
-	if (Url.StartsWith(TEXT("file://")))
-	{
-		// open local files via platform file system
-		TSharedPtr<FArchive, ESPMode::ThreadSafe> Archive;
-		const TCHAR* FilePath = &Url[7];
+	OpenAsync(Url, nullptr, Options);
 
-		if ((Options != nullptr) && Options->GetMediaOption("PrecacheFile", false))
-		{
-			FArrayReader* Reader = new FArrayReader;
+	return true;
+}
 
-			if (FFileHelper::LoadFileToArray(*Reader, FilePath))
-			{
-				Archive = MakeShareable(Reader);
-			}
-			else
-			{
-				delete Reader;
-			}
-		}
-		else
-		{
-			Archive = MakeShareable(IFileManager::Get().CreateFileReader(FilePath));
-		}
 
-		if (!Archive.IsValid())
-		{
-			UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Failed to open media file: %s"), FilePath);
-			return false;
-		}
+bool FVlcMediaPlayer::Open(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl, const IMediaOptions* Options)
+{
+	Close();
 
-		if (!MediaSource.OpenArchive(Archive.ToSharedRef(), Url))
-		{
-			return false;
-		}
-	}
-	else if (!MediaSource.OpenUrl(Url))
+	if (OriginalUrl.IsEmpty())
 	{
 		return false;
 	}
 
-	return InitializePlayer();
+	OpenAsync(OriginalUrl, Archive, Options);
+
+	return true;
 }
 
 
-bool FVlcMediaPlayer::Open(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl, const IMediaOptions* /*Options*/)
+void FVlcMediaPlayer::TickInput(FTimespan DeltaTime, FTimespan /*Timecode*/)
 {
-	Close();
+	TickOpenTask();
 
-	if (OriginalUrl.IsEmpty() || !MediaSource.OpenArchive(Archive, OriginalUrl))
+	if ((IdlePlayer != nullptr) && (FPlatformTime::Seconds() - IdleSince >= VlcMediaPlayer::IdlePlayerTimeout))
 	{
-		return false;
+		ReapIdlePlayer();
 	}
-	
-	return InitializePlayer();
-}
-
 
-void FVlcMediaPlayer::TickInput(FTimespan DeltaTime, FTimespan /*Timecode*/)
-{
 	if (Player == nullptr)
 	{
 		return;
 	}
 
 	// process events
-	libvlc_event_e Event;
+	FVlcMediaPlayerEvent Event;
+	bool NewBufferFill = false;
+	bool SeekCompleted = false;
+	bool TracksChanged = false;
 
-	while (Events.Dequeue(Event))
+	while ((Player != nullptr) && Events.Dequeue(Event))
 	{
-		switch (Event)
+		switch (Event.Type)
 		{
 		case libvlc_event_e::libvlc_MediaMetaChanged:
 			EventSink.ReceiveMediaEvent(EMediaEvent::MetadataChanged);
 			break;
 
 		case libvlc_event_e::libvlc_MediaPlayerBuffering:
-			EventSink.ReceiveMediaEvent(EMediaEvent::MediaBuffering);
+			BufferFill = Event.BufferFill;
+			NewBufferFill = true;
+			break;
+
+		case libvlc_event_e::libvlc_MediaPlayerESAdded:
+		case libvlc_event_e::libvlc_MediaPlayerESDeleted:
+		case libvlc_event_e::libvlc_MediaPlayerESSelected:
+			UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Player %p: Elementary stream %i changed"), this, Event.EsId);
+			TracksChanged = true;
 			break;
 
-		
 		case libvlc_event_e::libvlc_MediaParsedChanged:
-			Callbacks.Initialize(*Player);
 			EventSink.ReceiveMediaEvent(EMediaEvent::TracksChanged);
 			break;
 
@@ -438,14 +605,33 @@ void FVlcMediaPlayer::TickInput(FTimespan DeltaTime, FTimespan /*Timecode*/)
 			break;
 
 		case libvlc_event_e::libvlc_MediaPlayerEndReached:
+			if (!ShouldLoop && (Playlist.Num() > 0))
+			{
+				EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackEndReached);
+
+				if ((PreloadPlayer != nullptr) && PreloadPaused.load())
+				{
+					++NumPreloadedHandovers;
+					HandOverPreload();
+				}
+				else
+				{
+					// keep the ended player & its last frame until the next item was opened
+					++NumLateHandovers;
+					HandOverPending = true;
+				}
+				break;
+			}
+
 			libvlc_media_player_stop(Player);
 			
-			Callbacks.GetSamples().FlushSamples();
+			Callbacks->FlushSamples();
 			EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackEndReached);
 
+			// inputs that don't repeat, i.e. that were started before looping was enabled, are restarted
 			if (ShouldLoop && (CurrentRate != 0.0f))
 			{
-				CurrentTime = FTimespan::Zero();
+				Clock.Reset(FTimespan::Zero());
 				SetRate(CurrentRate);
 			}
 			else
@@ -462,8 +648,8 @@ void FVlcMediaPlayer::TickInput(FTimespan DeltaTime, FTimespan /*Timecode*/)
 			EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackResumed);
 			break;
 
-		case libvlc_event_e::libvlc_MediaPlayerPositionChanged:
-			EventSink.ReceiveMediaEvent(EMediaEvent::SeekCompleted);
+		case libvlc_event_e::libvlc_MediaPlayerVout:
+			UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Player %p: %i video outputs"), this, Event.VoutCount);
 			break;
 
 		default:
@@ -471,71 +657,535 @@ void FVlcMediaPlayer::TickInput(FTimespan DeltaTime, FTimespan /*Timecode*/)
 		}
 	}
 
-	const libvlc_state_t State = libvlc_media_player_get_state(Player);
+	TickPreload();
+
+	if (Player == nullptr)
+	{
+		return;
+	}
+
+	// a repeating input wrapped around to the beginning
+	const uint32 Loops = NumLoops.load();
+
+	if (Loops != CompletedLoops)
+	{
+		CompletedLoops = Loops;
+
+		Clock.Reset(FTimespan::Zero());
+		EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackEndReached);
+
+		// looping was disabled after the input was started
+		if (!ShouldLoop)
+		{
+			libvlc_media_player_stop(Player);
+
+			Callbacks->FlushSamples();
+			EventSink.ReceiveMediaEvent(EMediaEvent::PlaybackSuspended);
+		}
+	}
+
+	// VLC reported a time near the target of the most recent seek
+	const uint32 AppliedSeek = AppliedSeekGeneration.load();
+
+	if (AppliedSeek != CompletedSeekGeneration)
+	{
+		CompletedSeekGeneration = AppliedSeek;
+		SeekCompleted = true;
+	}
+
+	// report progress of loading a precached file as buffering
+	const float NewPrecacheProgress = MediaSource->GetPrecacheProgress();
+
+	if (NewPrecacheProgress != PrecacheProgress)
+	{
+		PrecacheProgress = NewPrecacheProgress;
+		NewBufferFill = true;
+	}
+
+	// deliver high-frequency events at most once per tick
+	if (NewBufferFill)
+	{
+		EventSink.ReceiveMediaEvent(EMediaEvent::MediaBuffering);
+	}
+
+	if (SeekCompleted)
+	{
+		EventSink.ReceiveMediaEvent(EMediaEvent::SeekCompleted);
+	}
+
+	if (TracksChanged)
+	{
+		EventSink.ReceiveMediaEvent(EMediaEvent::TracksChanged);
+	}
 
 	// update current time & rate
-	if (State == libvlc_state_t::libvlc_Playing)
+	CurrentRate = (CachedState.load() == libvlc_state_t::libvlc_Playing) ? PlaybackRate : 0.0f;
+
+	const int64 DecoderTime = CachedTime.load();
+	Clock.Tick(DeltaTime, CurrentRate, (DecoderTime >= 0) ? FTimespan::FromMilliseconds(DecoderTime) : FTimespan::MinValue());
+
+	Callbacks->SetCurrentTime(Clock.GetTime(), CurrentRate);
+
+	if ((Callbacks->ForwardVideoSamples() > 0) && AwaitingFirstFrame)
 	{
-		CurrentRate = libvlc_media_player_get_rate(Player);
-		CurrentTime += DeltaTime * CurrentRate;
+		AwaitingFirstFrame = false;
+		LastFirstFrameTime = FPlatformTime::Seconds() - OpenStartTime;
+		TotalFirstFrameTime += LastFirstFrameTime;
+		++NumFirstFrames;
+
+		UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Player %p: First frame of %s after %.1f ms"), this, *GetUrl(), LastFirstFrameTime * 1000.0);
 	}
-	else
+
+	Tracks.SetVideoFrameRate(Callbacks->GetVideoFrameRate());
+}
+
+
+/* IVlcMediaPlaylist interface
+ *****************************************************************************/
+
+void FVlcMediaPlayer::AddToPlaylist(const FString& Url)
+{
+	if (!Url.IsEmpty())
 	{
-		CurrentRate = 0.0f;
+		Playlist.Add(Url);
 	}
+}
+
 
-	Callbacks.SetCurrentTime(CurrentTime);
+void FVlcMediaPlayer::ClearPlaylist()
+{
+	// the ended player that was waiting for the next item is no longer needed
+	if (HandOverPending)
+	{
+		Close();
+	}
+
+	DiscardPreload();
+	Playlist.Empty();
+}
+
+
+int32 FVlcMediaPlayer::GetPlaylistLength() const
+{
+	return Playlist.Num();
 }
 
 
 /* FVlcMediaPlayer implementation
  *****************************************************************************/
 
-bool FVlcMediaPlayer::InitializePlayer()
+void FVlcMediaPlayer::DetachEvents()
 {
-	// create player for media source
-	Player = libvlc_media_player_new_from_media(MediaSource.GetMedia());
+	libvlc_event_manager_t* MediaEventManager = libvlc_media_event_manager(MediaSource->GetMedia());
+	libvlc_event_manager_t* PlayerEventManager = libvlc_media_player_event_manager(Player);
 
-	if (Player == nullptr)
+	if (MediaEventManager != nullptr)
 	{
-		UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Failed to initialize media player: %s"), ANSI_TO_TCHAR(libvlc_errmsg()));
-		return false;
+		libvlc_event_detach(MediaEventManager, libvlc_event_e::libvlc_MediaParsedChanged, &FVlcMediaPlayer::StaticEventCallback, this);
 	}
 
-	Tracks.Initialize(*Player, Info);
-	View.Initialize(*Player);
-	
+	if (PlayerEventManager != nullptr)
+	{
+		for (const libvlc_event_e PlayerEvent : VlcMediaPlayer::PlayerEvents)
+		{
+			libvlc_event_detach(PlayerEventManager, PlayerEvent, &FVlcMediaPlayer::StaticEventCallback, this);
+		}
+	}
+}
+
+
+void FVlcMediaPlayer::DiscardPreload()
+{
+	HandOverPending = false;
+
+	if (PreloadTask.IsValid())
+	{
+		PreloadTask->Cancel();
+		PreloadTask.Reset();
+	}
+
+	if (PreloadPlayer != nullptr)
+	{
+		libvlc_event_manager_t* PreloadEventManager = libvlc_media_player_event_manager(PreloadPlayer);
+
+		if (PreloadEventManager != nullptr)
+		{
+			libvlc_event_detach(PreloadEventManager, libvlc_event_e::libvlc_MediaPlayerPaused, &FVlcMediaPlayer::StaticPreloadEventCallback, this);
+		}
+
+		FVlcMediaPlayerReaper::Get().Reap(PreloadPlayer, PreloadSource, PreloadCallbacks);
+		PreloadPlayer = nullptr;
+	}
+
+	PreloadCallbacks.Reset();
+	PreloadPaused = false;
+	PreloadSource.Reset();
+	PreloadStepped = false;
+}
+
+
+void FVlcMediaPlayer::HandOverPreload()
+{
+	check(PreloadPlayer != nullptr);
+	check(Player != nullptr);
+
+	const float Rate = PlaybackRate;
+	const FString Url = Playlist[0];
+
+	Playlist.RemoveAt(0);
+
+	libvlc_event_manager_t* PreloadEventManager = libvlc_media_player_event_manager(PreloadPlayer);
+
+	if (PreloadEventManager != nullptr)
+	{
+		libvlc_event_detach(PreloadEventManager, libvlc_event_e::libvlc_MediaPlayerPaused, &FVlcMediaPlayer::StaticPreloadEventCallback, this);
+	}
+
+	// options accumulate on the media, and later inputs of the item must not start paused
+	libvlc_media_add_option(PreloadSource->GetMedia(), ":no-start-paused");
+
+	// retire the current player; its last frame remains visible until the next one arrives
+	DetachEvents();
+	Tracks.Shutdown();
+	View.Shutdown();
+	Events.Empty();
+
+	FVlcMediaPlayerReaper::Get().Reap(Player, MediaSource, Callbacks);
+
+	Callbacks = PreloadCallbacks.ToSharedRef();
+	MediaSource = MoveTemp(PreloadSource);
+	Player = PreloadPlayer;
+
+	HandOverPending = false;
+	PreloadCallbacks.Reset();
+	PreloadPaused = false;
+	PreloadPlayer = nullptr;
+	PreloadStepped = false;
+
+	if (!InitializePlayer())
+	{
+		UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Player %p: Failed to continue with %s"), this, *Url);
+		EventSink.ReceiveMediaEvent(EMediaEvent::MediaOpenFailed);
+
+		return;
+	}
+
+	// the preloaded player changed its state before the event handlers were attached
+	CachedPausable = (libvlc_media_player_can_pause(Player) != 0);
+	CachedSeekable = (libvlc_media_player_is_seekable(Player) != 0);
+	CachedState = libvlc_media_player_get_state(Player);
+
+	UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Player %p: Continuing with %s"), this, *Url);
+
+	SetRate((Rate > 0.0f) ? Rate : 1.0f);
+}
+
+
+bool FVlcMediaPlayer::InitializePlayer()
+{
+	check(Player != nullptr);
+	check(MediaSource.IsValid());
+
 	// attach to event managers
-	libvlc_event_manager_t* MediaEventManager = libvlc_media_event_manager(MediaSource.GetMedia());
+	libvlc_event_manager_t* MediaEventManager = libvlc_media_event_manager(MediaSource->GetMedia());
 	libvlc_event_manager_t* PlayerEventManager = libvlc_media_player_event_manager(Player);
 
 	if ((MediaEventManager == nullptr) || (PlayerEventManager == nullptr))
 	{
-		libvlc_media_player_release(Player);
+		FVlcMediaPlayerReaper::Get().Reap(Player, MediaSource, Callbacks);
+		Callbacks = MakeShared<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe>();
+
+		MediaSource.Reset();
 		Player = nullptr;
 
 		return false;
 	}
 
+	Tracks.Initialize(*Player, Info);
+	View.Initialize(*Player);
+
+	Callbacks->SetNominalVideoFrameRate(Tracks.GetNominalVideoFrameRate());
+
+	if (ShouldLoop)
+	{
+		SetInputRepeat(true);
+	}
+
 	libvlc_event_attach(MediaEventManager, libvlc_event_e::libvlc_MediaParsedChanged, &FVlcMediaPlayer::StaticEventCallback, this);
-	libvlc_event_attach(PlayerEventManager, libvlc_event_e::libvlc_MediaPlayerEndReached, &FVlcMediaPlayer::StaticEventCallback, this);
-	libvlc_event_attach(PlayerEventManager, libvlc_event_e::libvlc_MediaPlayerPlaying, &FVlcMediaPlayer::StaticEventCallback, this);
-	libvlc_event_attach(PlayerEventManager, libvlc_event_e::libvlc_MediaPlayerPositionChanged, &FVlcMediaPlayer::StaticEventCallback, this);
-	libvlc_event_attach(PlayerEventManager, libvlc_event_e::libvlc_MediaPlayerStopped, &FVlcMediaPlayer::StaticEventCallback, this);
-	libvlc_event_attach(PlayerEventManager, libvlc_event_e::libvlc_MediaMetaChanged, &FVlcMediaPlayer::StaticEventCallback, this);
-	libvlc_event_attach(PlayerEventManager, libvlc_event_e::libvlc_MediaPlayerBuffering, &FVlcMediaPlayer::StaticEventCallback, this);
-	libvlc_event_attach(PlayerEventManager, libvlc_event_e::libvlc_MediaPlayerOpening, &FVlcMediaPlayer::StaticEventCallback, this);
+
+	for (const libvlc_event_e PlayerEvent : VlcMediaPlayer::PlayerEvents)
+	{
+		libvlc_event_attach(PlayerEventManager, PlayerEvent, &FVlcMediaPlayer::StaticEventCallback, this);
+	}
 
 	// initialize player
+	Clock.Reset(FTimespan::Zero());
 	CurrentRate = 0.0f;
-	CurrentTime = FTimespan::Zero();
+	Events.Empty();
+	ResetCachedState();
 
+	EventSink.ReceiveMediaEvent(EMediaEvent::TracksChanged);
 	EventSink.ReceiveMediaEvent(EMediaEvent::MediaOpened);
 
 	return true;
 }
 
 
+void FVlcMediaPlayer::OpenAsync(const FString& Url, const TSharedPtr<FArchive, ESPMode::ThreadSafe>& Archive, const IMediaOptions* Options)
+{
+	const bool Precache = (Options != nullptr) && Options->GetMediaOption("PrecacheFile", false);
+
+	const FVlcMediaPlayerCallbacks::FVideoSettings VideoSettings = FVlcMediaPlayerCallbacks::GetVideoSettings(Options);
+	InputOptions = FVlcMediaPlayerSource::GetInputOptions(Options);
+
+	// VLC keeps the idle player's video output for media of the same format, so it can't be reused with different output settings
+	if ((IdlePlayer != nullptr) && !Callbacks->HasVideoOutput(VideoSettings))
+	{
+		ReapIdlePlayer();
+	}
+
+	OpenTask = MakeShared<FVlcMediaPlayerOpenTask, ESPMode::ThreadSafe>(VlcInstance, Url, Archive, Precache, InputOptions);
+
+	if (IdlePlayer == nullptr)
+	{
+		Callbacks->Configure(VideoSettings);
+	}
+	else
+	{
+		// switch the media of the idle player, which keeps its outputs & callbacks
+		OpenTask->ReusePlayer(IdlePlayer, IdleSource, Callbacks, VideoSettings);
+
+		IdlePlayer = nullptr;
+		IdleSource.Reset();
+	}
+
+	OpenTask->Start(); // retried in TickOpenTask if too many opens are running
+	AwaitingFirstFrame = true;
+	OpenProgress = 0.0f;
+	OpenStartTime = FPlatformTime::Seconds();
+}
+
+
+void FVlcMediaPlayer::ReapIdlePlayer()
+{
+	if (IdlePlayer == nullptr)
+	{
+		return;
+	}
+
+	FVlcMediaPlayerReaper::Get().Reap(IdlePlayer, IdleSource, Callbacks);
+	Callbacks = MakeShared<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe>();
+
+	IdlePlayer = nullptr;
+	IdleSource.Reset();
+}
+
+
+void FVlcMediaPlayer::ResetCachedState()
+{
+	BufferFill = 100.0f;
+	CachedPausable = false;
+	CachedSeekable = false;
+	CachedState = libvlc_state_t::libvlc_NothingSpecial;
+	CachedTime = -1;
+	CompletedLoops = NumLoops.load();
+	InputRepeats = false;
+	PlaybackRate = 1.0f;
+	PrecacheProgress = 1.0f;
+
+	FScopeLock Lock(&SeekCriticalSection);
+
+	AppliedSeekGeneration = SeekGeneration.load();
+	CompletedSeekGeneration = AppliedSeekGeneration.load();
+	SeekTarget = -1;
+}
+
+
+void FVlcMediaPlayer::SetInputRepeat(bool Repeat)
+{
+	check(MediaSource.IsValid());
+
+	// options accumulate on the media, and the most recent one wins
+	libvlc_media_add_option(MediaSource->GetMedia(), Repeat ? ":input-repeat=65535" : ":input-repeat=0");
+}
+
+
+void FVlcMediaPlayer::StartPreroll()
+{
+	check(PreloadPlayer != nullptr);
+
+	PreloadCallbacks = MakeShared<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe>();
+	PreloadCallbacks->Configure(*Callbacks);
+	PreloadCallbacks->Initialize(*PreloadPlayer);
+
+	// the current item already ended, so there is no time to preroll
+	if (HandOverPending)
+	{
+		HandOverPreload();
+
+		return;
+	}
+
+	libvlc_event_manager_t* PreloadEventManager = libvlc_media_player_event_manager(PreloadPlayer);
+
+	if (PreloadEventManager != nullptr)
+	{
+		libvlc_event_attach(PreloadEventManager, libvlc_event_e::libvlc_MediaPlayerPaused, &FVlcMediaPlayer::StaticPreloadEventCallback, this);
+	}
+
+	// start the input, but pause it before anything is played; the first frame is decoded in TickPreload
+	libvlc_media_add_option(PreloadSource->GetMedia(), ":start-paused");
+	libvlc_media_player_play(PreloadPlayer);
+}
+
+
+void FVlcMediaPlayer::TickOpenTask()
+{
+	if (!OpenTask.IsValid() || !OpenTask->Start())
+	{
+		return;
+	}
+
+	const float Progress = OpenTask->GetProgress();
+
+	if (Progress != OpenProgress)
+	{
+		OpenProgress = Progress;
+		EventSink.ReceiveMediaEvent(EMediaEvent::MediaBuffering);
+	}
+
+	if (!OpenTask->IsCompleted())
+	{
+		return;
+	}
+
+	const bool Opened = OpenTask->Finish(MediaSource, Player);
+	const bool Reused = OpenTask->IsReusingPlayer();
+	const FString Url = OpenTask->GetUrl();
+
+	OpenTask.Reset();
+
+	if (!Opened)
+	{
+		// a reused player was handed to the reaper together with the callbacks
+		if (Reused)
+		{
+			Callbacks = MakeShared<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe>();
+		}
+	}
+	else
+	{
+		// the media was parsed while opening, so the callbacks can be registered right away
+		if (Reused)
+		{
+			Callbacks->Restart();
+		}
+		else
+		{
+			Callbacks->Initialize(*Player);
+		}
+
+		if (InitializePlayer())
+		{
+			if (Reused)
+			{
+				LastSwitchTime = FPlatformTime::Seconds() - OpenStartTime;
+				TotalSwitchTime += LastSwitchTime;
+				++NumMediaSwitches;
+
+				UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Player %p: Switched to %s in %.1f ms"), this, *Url, LastSwitchTime * 1000.0);
+			}
+
+			return;
+		}
+	}
+
+	UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Player %p: Failed to open %s"), this, *Url);
+	EventSink.ReceiveMediaEvent(EMediaEvent::MediaOpenFailed);
+}
+
+
+void FVlcMediaPlayer::TickPreload()
+{
+	if (PreloadTask.IsValid())
+	{
+		if (!PreloadTask->Start() || !PreloadTask->IsCompleted())
+		{
+			return;
+		}
+
+		const bool Opened = PreloadTask->Finish(PreloadSource, PreloadPlayer);
+
+		PreloadTask.Reset();
+
+		if (Opened)
+		{
+			StartPreroll();
+		}
+		else
+		{
+			UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Player %p: Failed to preload %s, skipping it"), this, *Playlist[0]);
+			Playlist.RemoveAt(0);
+		}
+
+		return;
+	}
+
+	if (PreloadPlayer != nullptr)
+	{
+		if (!PreloadPaused.load())
+		{
+			return;
+		}
+
+		if (HandOverPending)
+		{
+			HandOverPreload();
+		}
+		else if (!PreloadStepped)
+		{
+			// decode & display the first frame while paused
+			libvlc_media_player_next_frame(PreloadPlayer);
+			PreloadStepped = true;
+		}
+
+		return;
+	}
+
+	if ((Playlist.Num() == 0) || ShouldLoop)
+	{
+		// the ended player that was waiting for the next item is no longer needed
+		if (HandOverPending)
+		{
+			Close();
+		}
+
+		return;
+	}
+
+	// start preloading when the current item is about to end (immediately if its duration is unknown)
+	if (!HandOverPending)
+	{
+		if (CachedState.load() != libvlc_state_t::libvlc_Playing)
+		{
+			return;
+		}
+
+		const FTimespan Duration = GetDuration();
+
+		if ((Duration > FTimespan::Zero()) && (Duration - Clock.GetTime() > GetDefault<UVlcMediaPlayerSettings>()->PreloadLeadTime))
+		{
+			return;
+		}
+	}
+
+	UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Player %p: Preloading %s"), this, *Playlist[0]);
+
+	PreloadTask = MakeShared<FVlcMediaPlayerOpenTask, ESPMode::ThreadSafe>(VlcInstance, Playlist[0], nullptr, false, InputOptions);
+	PreloadTask->Start(); // retried in TickPreload if too many opens are running
+}
+
+
 /* FVlcMediaPlayer static functions
  *****************************************************************************/
 
@@ -546,10 +1196,102 @@ void FVlcMediaPlayer::StaticEventCallback(const libvlc_event_t* Event, void* Use
 		return;
 	}
 
-	UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Player %p: Event [%s]"), UserData, UTF8_TO_TCHAR(libvlc_event_type_name(Event->type)));
-	
-	if (UserData != nullptr)
+	if (UserData == nullptr)
+	{
+		return;
+	}
+
+	FVlcMediaPlayer* MediaPlayer = (FVlcMediaPlayer*)UserData;
+
+	// update cached state on VLC's event thread, so that the game thread never has to poll it
+	switch (Event->type)
+	{
+	case libvlc_event_e::libvlc_MediaPlayerTimeChanged:
+		{
+			const int64 NewTime = Event->u.media_player_time_changed.new_time;
+
+			FScopeLock Lock(&MediaPlayer->SeekCriticalSection);
+
+			if (MediaPlayer->SeekTarget >= 0)
+			{
+				// times from before the seek was applied would move the clock back and look like loops
+				if (VlcMediaPlayer::IsPastSeek(NewTime, MediaPlayer->SeekTarget, MediaPlayer->SeekOrigin, FPlatformTime::Seconds() - MediaPlayer->SeekStartTime))
+				{
+					MediaPlayer->AppliedSeekGeneration = MediaPlayer->SeekGeneration.load();
+					MediaPlayer->CachedTime = NewTime;
+					MediaPlayer->SeekTarget = -1;
+				}
+			}
+			else
+			{
+				const int64 PreviousTime = MediaPlayer->CachedTime.exchange(NewTime);
+
+				// a repeating input jumps back to the beginning without a seek being requested
+				if (MediaPlayer->InputRepeats.load() && (NewTime + VlcMediaPlayer::MinLoopJump < PreviousTime))
+				{
+					MediaPlayer->Callbacks->MarkLoopSeam();
+					++MediaPlayer->NumLoops;
+				}
+			}
+		}
+		return; // too frequent to be logged or queued
+
+	case libvlc_event_e::libvlc_MediaPlayerPausableChanged:
+		MediaPlayer->CachedPausable = (Event->u.media_player_pausable_changed.new_pausable != 0);
+		break;
+
+	case libvlc_event_e::libvlc_MediaPlayerSeekableChanged:
+		MediaPlayer->CachedSeekable = (Event->u.media_player_seekable_changed.new_seekable != 0);
+		break;
+
+	case libvlc_event_e::libvlc_MediaPlayerEncounteredError:
+		MediaPlayer->CachedState = libvlc_state_t::libvlc_Error;
+		break;
+
+	case libvlc_event_e::libvlc_MediaPlayerEndReached:
+		MediaPlayer->CachedState = libvlc_state_t::libvlc_Ended;
+		break;
+
+	case libvlc_event_e::libvlc_MediaPlayerOpening:
+		MediaPlayer->CachedState = libvlc_state_t::libvlc_Opening;
+		break;
+
+	case libvlc_event_e::libvlc_MediaPlayerPaused:
+		MediaPlayer->CachedState = libvlc_state_t::libvlc_Paused;
+		break;
+
+	case libvlc_event_e::libvlc_MediaPlayerPlaying:
+		MediaPlayer->CachedState = libvlc_state_t::libvlc_Playing;
+		break;
+
+	case libvlc_event_e::libvlc_MediaPlayerStopped:
+		{
+			FScopeLock Lock(&MediaPlayer->SeekCriticalSection);
+
+			MediaPlayer->CachedState = libvlc_state_t::libvlc_Stopped;
+			MediaPlayer->CachedTime = -1;
+			MediaPlayer->SeekTarget = -1; // the next input starts from the beginning
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	// buffering updates are too frequent to be logged
+	if (Event->type != libvlc_event_e::libvlc_MediaPlayerBuffering)
+	{
+		UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Player %p: Event [%s]"), UserData, UTF8_TO_TCHAR(libvlc_event_type_name(Event->type)));
+	}
+
+	MediaPlayer->Events.Enqueue(FVlcMediaPlayerEvent(*Event));
+}
+
+
+void FVlcMediaPlayer::StaticPreloadEventCallback(const libvlc_event_t* Event, void* UserData)
+{
+	if ((Event != nullptr) && (UserData != nullptr) && (Event->type == libvlc_event_e::libvlc_MediaPlayerPaused))
 	{
-		((FVlcMediaPlayer*)UserData)->Events.Enqueue(static_cast<libvlc_event_e>(Event->type));
+		((FVlcMediaPlayer*)UserData)->PreloadPaused = true;
 	}
 }
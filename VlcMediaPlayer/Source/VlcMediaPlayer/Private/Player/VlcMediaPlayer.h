@@ -4,18 +4,25 @@
 
 #include "CoreMinimal.h"
 #include "Containers/Queue.h"
+#include "HAL/CriticalSection.h"
 #include "IMediaCache.h"
 #include "IMediaControls.h"
 #include "IMediaPlayer.h"
 #include "IMediaSamples.h"
+#include "IVlcMediaPlaylist.h"
 
 #include "VlcMediaPlayerCallbacks.h"
+#include "VlcMediaPlayerClock.h"
+#include "VlcMediaPlayerEvent.h"
+#include "VlcMediaPlayerOpenTask.h"
 #include "VlcMediaPlayerSource.h"
 #include "VlcMediaPlayerTracks.h"
 #include "VlcMediaPlayerView.h"
 
 #include "VlcWrapper.h"
 
+#include <atomic>
+
 class IMediaEventSink;
 class IMediaOutput;
 
@@ -34,6 +41,7 @@ class FVlcMediaPlayer
 	: public IMediaPlayer
 	, protected IMediaCache
 	, protected IMediaControls
+	, public IVlcMediaPlaylist
 {
 public:
 
@@ -67,15 +75,68 @@ public:
 	virtual bool Open(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl, const IMediaOptions* Options) override;
 	virtual void TickInput(FTimespan DeltaTime, FTimespan Timecode) override;
 
+public:
+
+	//~ IVlcMediaPlaylist interface
+
+	virtual void AddToPlaylist(const FString& Url) override;
+	virtual void ClearPlaylist() override;
+	virtual int32 GetPlaylistLength() const override;
+
 protected:
 
+	/** Detach the event handlers from the VLC player and its media. */
+	void DetachEvents();
+
+	/** Cancel preloading the next playlist item, and release the preloaded player. */
+	void DiscardPreload();
+
+	/** Replace the current VLC player with the one that preloaded the next playlist item. */
+	void HandOverPreload();
+
 	/**
-	 * Initialize the media player.
+	 * Initialize the media player after the media source was opened.
+	 *
+	 * The callbacks must have been registered with the VLC player.
 	 *
 	 * @return true on success, false otherwise.
 	 */
 	bool InitializePlayer();
 
+	/**
+	 * Start opening the specified media source in the background.
+	 *
+	 * @param Url The media URL.
+	 * @param Archive The archive to read media data from, or nullptr to open the URL.
+	 * @param Options Optional media options.
+	 */
+	void OpenAsync(const FString& Url, const TSharedPtr<FArchive, ESPMode::ThreadSafe>& Archive, const IMediaOptions* Options);
+
+	/** Hand the idle VLC player to the reaper, if any. */
+	void ReapIdlePlayer();
+
+	/** Reset the cached player state to that of a newly created player. */
+	void ResetCachedState();
+
+	/**
+	 * Set whether the next input started by the VLC player repeats the media.
+	 *
+	 * VLC reads the option when the input starts, so that looping is gapless only if
+	 * it was enabled before playback started.
+	 *
+	 * @param Repeat Whether the input should repeat.
+	 */
+	void SetInputRepeat(bool Repeat);
+
+	/** Start decoding the preloaded playlist item, stopping at its first frame. */
+	void StartPreroll();
+
+	/** Report the progress of a pending open operation, and adopt its results when done. */
+	void TickOpenTask();
+
+	/** Preload the next playlist item when the current one is about to end. */
+	void TickPreload();
+
 protected:
 
 	//~ IMediaControls interface
@@ -97,38 +158,167 @@ private:
 	/** Handles event callbacks. */
 	static void StaticEventCallback(const libvlc_event_t* Event, void* UserData);
 
+	/** Handles event callbacks of the preloaded VLC player. */
+	static void StaticPreloadEventCallback(const libvlc_event_t* Event, void* UserData);
+
 private:
 
-	/** VLC callback manager. */
-	FVlcMediaPlayerCallbacks Callbacks;
+	/** The seek generation of the most recent seek that VLC reported a time for (updated from VLC events). */
+	std::atomic<uint32> AppliedSeekGeneration;
+
+	/** Whether the pending or most recent open operation has not forwarded a video frame yet. */
+	bool AwaitingFirstFrame;
+
+	/** Buffer fill level reported by the most recent Buffering event (in percent). */
+	float BufferFill;
+
+	/** Whether the media can be paused (updated from VLC events). */
+	std::atomic<bool> CachedPausable;
+
+	/** Whether the media is seekable (updated from VLC events). */
+	std::atomic<bool> CachedSeekable;
+
+	/** The player's state (updated from VLC events). */
+	std::atomic<libvlc_state_t> CachedState;
+
+	/** The most recent time reported by VLC (in milliseconds, or -1 if unknown or while a seek is pending). */
+	std::atomic<int64> CachedTime;
+
+	/** VLC callback manager (handed to the reaper when the player is closed). */
+	TSharedRef<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe> Callbacks;
+
+	/** The player's play time. */
+	FVlcMediaPlayerClock Clock;
+
+	/** The number of loops for which PlaybackEndReached was last sent. */
+	uint32 CompletedLoops;
+
+	/** The seek generation for which SeekCompleted was last sent. */
+	uint32 CompletedSeekGeneration;
 
 	/** Current playback rate. */
 	float CurrentRate;
 
-	/** Current playback time (to work around VLC's broken time tracking). */
-	FTimespan CurrentTime;
-
 	/** The media event handler. */
 	IMediaEventSink& EventSink;
 
 	/** Collection of received player events. */
-	TQueue<libvlc_event_e, EQueueMode::Mpsc> Events;
+	TQueue<FVlcMediaPlayerEvent, EQueueMode::Mpsc> Events;
+
+	/** Whether the current playlist item ended before the next one was preloaded. */
+	bool HandOverPending;
+
+	/** A paused VLC player that is kept after closing, so that the next Open can reuse it. */
+	libvlc_media_player_t* IdlePlayer;
+
+	/** Time at which the idle player was closed (in seconds). */
+	double IdleSince;
+
+	/** The media source that the idle player was playing. */
+	TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe> IdleSource;
 
 	/** Media information string. */
 	FString Info;
 
+	/** VLC input options of the most recently opened media (also used for playlist items). */
+	TArray<FString> InputOptions;
+
+	/** Whether the current input repeats the media instead of ending. */
+	std::atomic<bool> InputRepeats;
+
+	/** Time from the most recent open request to its first video frame (in seconds). */
+	double LastFirstFrameTime;
+
+	/** Time that the most recent media switch took (in seconds). */
+	double LastSwitchTime;
+
 	/** The media source (from URL or archive). */
-	FVlcMediaPlayerSource MediaSource;
+	TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe> MediaSource;
+
+	/** Number of open operations that reached their first video frame. */
+	int32 NumFirstFrames;
+
+	/** Number of playlist items that were handed over before they finished preloading. */
+	int32 NumLateHandovers;
+
+	/** Number of times that a repeating input wrapped around (updated from VLC events). */
+	std::atomic<uint32> NumLoops;
+
+	/** Number of times that the media was switched on a reused VLC player. */
+	int32 NumMediaSwitches;
+
+	/** Number of playlist items that were handed over after they finished preloading. */
+	int32 NumPreloadedHandovers;
+
+	/** The most recently reported progress of the pending open operation. */
+	float OpenProgress;
+
+	/** Time at which the pending open operation was started (in seconds). */
+	double OpenStartTime;
+
+	/** The pending open operation, if any. */
+	TSharedPtr<FVlcMediaPlayerOpenTask, ESPMode::ThreadSafe> OpenTask;
+
+	/** The rate that was last set on the player (retained while paused). */
+	float PlaybackRate;
 
 	/** The VLC media player object. */
 	libvlc_media_player_t* Player;
 
+	/** URLs of the media to play after the current media, in order. */
+	TArray<FString> Playlist;
+
+	/** Fraction of a precached media file that was most recently reported as loaded. */
+	float PrecacheProgress;
+
+	/** The callbacks registered with the preloaded VLC player. */
+	TSharedPtr<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe> PreloadCallbacks;
+
+	/** Whether the preloaded VLC player paused at the beginning of its media (updated from VLC events). */
+	std::atomic<bool> PreloadPaused;
+
+	/** The VLC player that preloads the next playlist item. */
+	libvlc_media_player_t* PreloadPlayer;
+
+	/** The media source of the next playlist item. */
+	TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe> PreloadSource;
+
+	/** Whether the preloaded VLC player was stepped to its first frame. */
+	bool PreloadStepped;
+
+	/** The pending preload operation, if any. */
+	TSharedPtr<FVlcMediaPlayerOpenTask, ESPMode::ThreadSafe> PreloadTask;
+
+	/** Critical section for synchronizing access to the pending seek. */
+	FCriticalSection SeekCriticalSection;
+
+	/** Incremented each time a seek is requested (guarded by SeekCriticalSection). */
+	std::atomic<uint32> SeekGeneration;
+
+	/** The play time at which the pending seek was requested (in milliseconds). */
+	int64 SeekOrigin;
+
+	/** Time at which the pending seek was requested (in seconds). */
+	double SeekStartTime;
+
+	/** The time that the pending seek jumps to (in milliseconds, or -1 if no seek is pending). */
+	int64 SeekTarget;
+
 	/** Whether playback should be looping. */
 	bool ShouldLoop;
 
+	/** Total time from open requests to their first video frames (in seconds). */
+	double TotalFirstFrameTime;
+
+	/** Total time that media switches took (in seconds). */
+	double TotalSwitchTime;
+
 	/** Track collection. */
 	FVlcMediaPlayerTracks Tracks;
 
 	/** View settings. */
 	FVlcMediaPlayerView View;
+
+	/** The LibVLC instance. */
+	libvlc_instance_t* VlcInstance;
 };
@@ -0,0 +1,294 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Containers/Array.h"
+#include "HAL/UnrealMemory.h"
+#include "Templates/SharedPointer.h"
+
+#include "VlcMediaPlayerAudioSample.h"
+
+#include <atomic>
+
+
+/**
+ * Single producer ring buffer for PCM audio frames.
+ *
+ * VLC's audio thread copies each block of frames into contiguous storage and hands out
+ * a persistent audio sample that refers to it. A region of the storage is reused once
+ * the sample that refers to it, and all samples before it, have been released by their
+ * consumers. Only the producer touches the ring's bookkeeping, so no locks are needed.
+ *
+ * The storage is allocated when the audio format is set up. Samples are allocated once
+ * when the ring is created, so that writing frames never touches the heap.
+ */
+class FVlcMediaPlayerAudioRing
+{
+	struct FSlot
+	{
+		/** Size of the referenced region (in bytes). */
+		SIZE_T Size;
+
+		/** Offset of the referenced region (in bytes). */
+		SIZE_T Offset;
+
+		/** The audio sample that refers to the region. */
+		TSharedRef<FVlcMediaPlayerAudioSample, ESPMode::ThreadSafe> Sample;
+	};
+
+public:
+
+	/** Maximum number of audio samples that can be in use at the same time. */
+	static const int32 NumSlots = 256;
+
+	/** Default constructor. */
+	FVlcMediaPlayerAudioRing()
+		: NumOverruns(0)
+		, NumUnderruns(0)
+		, Primed(false)
+		, ReadOffset(0)
+		, SlotCount(0)
+		, SlotHead(0)
+		, WriteOffset(0)
+	{
+		Slots.Reserve(NumSlots);
+
+		for (int32 Index = 0; Index < NumSlots; ++Index)
+		{
+			Slots.Add(FSlot{ 0, 0, MakeShared<FVlcMediaPlayerAudioSample, ESPMode::ThreadSafe>() });
+		}
+	}
+
+public:
+
+	/**
+	 * Make sure the storage can hold the specified amount of audio.
+	 *
+	 * This method must be called on the producer thread whenever the audio format changes.
+	 * Samples that are still in use keep the previous storage alive if it needs to be replaced.
+	 *
+	 * @param BytesPerSecond Number of bytes per second of audio in the new format.
+	 * @param Duration Amount of audio that the storage should hold (in seconds).
+	 */
+	void Configure(SIZE_T BytesPerSecond, double Duration)
+	{
+		const SIZE_T RequiredSize = Align((SIZE_T)(BytesPerSecond * Duration), 64);
+
+		if (Storage.IsValid() && ((SIZE_T)Storage->Num() >= RequiredSize))
+		{
+			return;
+		}
+
+		Storage = MakeShared<TArray<uint8>, ESPMode::ThreadSafe>();
+		Storage->SetNumUninitialized(RequiredSize);
+
+		Restart();
+	}
+
+	/**
+	 * Get the number of times that frames were dropped because the ring was full.
+	 *
+	 * @return Number of overruns.
+	 */
+	int32 GetNumOverruns() const
+	{
+		return NumOverruns.load();
+	}
+
+	/**
+	 * Get the number of times that the consumers released all frames before new ones were written.
+	 *
+	 * @return Number of underruns.
+	 */
+	int32 GetNumUnderruns() const
+	{
+		return NumUnderruns.load();
+	}
+
+	/**
+	 * Notify the ring that playback was interrupted.
+	 *
+	 * The ring running empty after a pause or flush is expected and not counted as an underrun.
+	 * This method must be called on the producer thread.
+	 */
+	void Interrupt()
+	{
+		Primed = false;
+	}
+
+	/**
+	 * Release the storage and reset the statistics.
+	 *
+	 * This method must not be called while the producer is writing.
+	 */
+	void Reset()
+	{
+		Storage.Reset();
+		Restart();
+
+		NumOverruns = 0;
+		NumUnderruns = 0;
+	}
+
+	/**
+	 * Copy a block of frames into the ring.
+	 *
+	 * This method must be called on the producer thread.
+	 *
+	 * @param Data The frames to copy.
+	 * @param Size Size of the frames (in bytes).
+	 * @param Frames Number of frames.
+	 * @param Channels Number of audio channels.
+	 * @param SampleFormat The sample format.
+	 * @param SampleRate The sample rate.
+	 * @param Time The play time of the first frame.
+	 * @param Duration The duration of the frames.
+	 * @return The audio sample that refers to the copied frames, or nullptr if the ring is full.
+	 */
+	TSharedPtr<FVlcMediaPlayerAudioSample, ESPMode::ThreadSafe> Write(
+		const void* Data,
+		SIZE_T Size,
+		uint32 Frames,
+		uint32 Channels,
+		EMediaAudioSampleFormat SampleFormat,
+		uint32 SampleRate,
+		FTimespan Time,
+		FTimespan Duration)
+	{
+		if (!Storage.IsValid() || (Data == nullptr) || (Size == 0))
+		{
+			return nullptr;
+		}
+
+		Reclaim();
+
+		if (SlotCount == 0)
+		{
+			if (Primed)
+			{
+				++NumUnderruns;
+			}
+
+			ReadOffset = 0;
+			WriteOffset = 0;
+		}
+
+		Primed = true;
+
+		// find a free sample & a contiguous region
+		FSlot& Slot = Slots[(SlotHead + SlotCount) % NumSlots];
+		SIZE_T Offset = 0;
+
+		if ((SlotCount == NumSlots) || !Slot.Sample.IsUnique() || !FindRegion(Size, Offset))
+		{
+			++NumOverruns;
+			return nullptr;
+		}
+
+		FMemory::Memcpy(Storage->GetData() + Offset, Data, Size);
+
+		Slot.Offset = Offset;
+		Slot.Size = Size;
+		Slot.Sample->Initialize(Storage, Offset, Frames, Channels, SampleFormat, SampleRate, Time, Duration);
+
+		WriteOffset = Offset + Size;
+		++SlotCount;
+
+		return Slot.Sample;
+	}
+
+protected:
+
+	/**
+	 * Find a contiguous region of free storage.
+	 *
+	 * @param Size The required size of the region (in bytes).
+	 * @param OutOffset Will contain the offset of the region.
+	 * @return true if a region was found, false if the ring is full.
+	 */
+	bool FindRegion(SIZE_T Size, SIZE_T& OutOffset) const
+	{
+		const SIZE_T Capacity = Storage->Num();
+
+		if (SlotCount == 0)
+		{
+			OutOffset = 0;
+			return (Size <= Capacity);
+		}
+
+		// frames in use wrap around the end of the storage
+		if (WriteOffset <= ReadOffset)
+		{
+			OutOffset = WriteOffset;
+			return (ReadOffset - WriteOffset >= Size);
+		}
+
+		if (Capacity - WriteOffset >= Size)
+		{
+			OutOffset = WriteOffset;
+			return true;
+		}
+
+		OutOffset = 0;
+		return (ReadOffset >= Size);
+	}
+
+	/** Reclaim the regions of samples that were released by their consumers. */
+	void Reclaim()
+	{
+		while ((SlotCount > 0) && Slots[SlotHead].Sample.IsUnique())
+		{
+			SlotHead = (SlotHead + 1) % NumSlots;
+			--SlotCount;
+		}
+
+		if (SlotCount > 0)
+		{
+			ReadOffset = Slots[SlotHead].Offset;
+		}
+
+		// consumers must be done reading before released regions are overwritten
+		std::atomic_thread_fence(std::memory_order_acquire);
+	}
+
+	/** Forget all regions in use, without reusing samples that are still referenced. */
+	void Restart()
+	{
+		SlotHead = (SlotHead + SlotCount) % NumSlots;
+		SlotCount = 0;
+
+		Primed = false;
+		ReadOffset = 0;
+		WriteOffset = 0;
+	}
+
+private:
+
+	/** Number of times that frames were dropped because the ring was full. */
+	std::atomic<int32> NumOverruns;
+
+	/** Number of times that the ring ran empty during playback. */
+	std::atomic<int32> NumUnderruns;
+
+	/** Whether frames were written since playback started or was interrupted. */
+	bool Primed;
+
+	/** Offset of the oldest region in use (in bytes). */
+	SIZE_T ReadOffset;
+
+	/** Number of samples in use. */
+	int32 SlotCount;
+
+	/** Index of the oldest sample in use. */
+	int32 SlotHead;
+
+	/** Persistent audio samples and the regions they refer to. */
+	TArray<FSlot> Slots;
+
+	/** The storage for the frames. */
+	TSharedPtr<TArray<uint8>, ESPMode::ThreadSafe> Storage;
+
+	/** Offset following the newest region in use (in bytes). */
+	SIZE_T WriteOffset;
+};
@@ -3,25 +3,28 @@
 #pragma once
 
 #include "CoreTypes.h"
+#include "Containers/Array.h"
 #include "IMediaAudioSample.h"
-#include "MediaObjectPool.h"
 #include "Misc/Timespan.h"
 #include "Templates/SharedPointer.h"
 
 
 /**
  * Audio sample generated by VLC player.
+ *
+ * The sample does not own its frames; it is a view onto a region of the
+ * audio ring buffer's storage, which it keeps alive while referenced.
+ *
+ * @see FVlcMediaPlayerAudioRing
  */
 class FVlcMediaPlayerAudioSample
 	: public IMediaAudioSample
-	, public IMediaPoolable
 {
 public:
 
 	/** Default constructor. */
 	FVlcMediaPlayerAudioSample()
 		: Buffer(nullptr)
-		, BufferSize(0)
 		, Channels(0)
 		, Duration(FTimespan::Zero())
 		, Frames(0)
@@ -31,29 +34,25 @@ public:
 	{ }
 
 	/** Virtual destructor. */
-	virtual ~FVlcMediaPlayerAudioSample()
-	{
-		FreeBuffer();
-	}
+	virtual ~FVlcMediaPlayerAudioSample() { }
 
 public:
 
 	/**
 	 * Initialize the sample.
 	 *
-	 * @param InBuffer The raw audio sample buffer.
-	 * @param InBufferSize The size of the buffer (in bytes).
+	 * @param InStorage The storage that holds the sample's frames.
+	 * @param InOffset Offset of the sample's frames within the storage (in bytes).
 	 * @param InFrames Number of frames in the buffer.
 	 * @param InChannels Number of audio channels.
 	 * @param InSampleFormat The sample format.
 	 * @param InSampleRate The sample rate.
 	 * @param InTime The sample time (in the player's local clock).
 	 * @param InDuration The duration for which the sample is valid.
-	 * @return true on success, false otherwise.
 	 */
-	bool Initialize(
-		const void* InBuffer,
-		uint32 InBufferSize,
+	void Initialize(
+		const TSharedPtr<TArray<uint8>, ESPMode::ThreadSafe>& InStorage,
+		SIZE_T InOffset,
 		uint32 InFrames,
 		uint32 InChannels,
 		EMediaAudioSampleFormat InSampleFormat,
@@ -61,18 +60,8 @@ public:
 		FTimespan InTime,
 		FTimespan InDuration)
 	{
-		if ((InBuffer == nullptr) || (InBufferSize == 0) || (InSampleFormat == EMediaAudioSampleFormat::Undefined))
-		{
-			return false;
-		}
-
-		if (InBufferSize > BufferSize)
-		{
-			Buffer = FMemory::Realloc(Buffer, InBufferSize);
-			BufferSize = InBufferSize;
-		}
-
-		FMemory::Memcpy(Buffer, InBuffer, InBufferSize);
+		Storage = InStorage;
+		Buffer = Storage->GetData() + InOffset;
 
 		Channels = InChannels;
 		Duration = InDuration;
@@ -80,8 +69,6 @@ public:
 		SampleFormat = InSampleFormat;
 		SampleRate = InSampleRate;
 		Time = InTime;
-
-		return true;
 	}
 
 public:
@@ -123,27 +110,10 @@ public:
 		return FMediaTimeStamp(Time);
 	}
 
-protected:
-
-	/** Free the sample buffer. */
-	void FreeBuffer()
-	{
-		if (Buffer != nullptr)
-		{
-			FMemory::Free(Buffer);
-
-			Buffer = nullptr;
-			BufferSize = 0;
-		}
-	}
-
 private:
 
-	/** The sample's frame buffer. */
-	void* Buffer;
-
-	/** Allocated size of the buffer (in bytes). */
-	SIZE_T BufferSize;
+	/** The sample's frames (points into Storage). */
+	const uint8* Buffer;
 
 	/** Number of audio channels. */
 	uint32 Channels;
@@ -160,10 +130,9 @@ private:
 	/** Audio sample rate (in samples per second). */
 	uint32 SampleRate;
 
+	/** The ring buffer storage that holds the frames. */
+	TSharedPtr<TArray<uint8>, ESPMode::ThreadSafe> Storage;
+
 	/** Play time for which the sample was generated. */
 	FTimespan Time;
 };
-
-
-/** Implements a pool for VLC audio sample objects. */
-class FVlcMediaAudioSamplePool : public TMediaObjectPool<FVlcMediaPlayerAudioSample> { };
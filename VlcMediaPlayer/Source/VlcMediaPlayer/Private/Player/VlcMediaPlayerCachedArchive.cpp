@@ -0,0 +1,105 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#include "VlcMediaPlayerCachedArchive.h"
+#include "VlcMediaPlayerPrivate.h"
+
+
+/* FVlcMediaPlayerCachedArchive structors
+ *****************************************************************************/
+
+FVlcMediaPlayerCachedArchive::FVlcMediaPlayerCachedArchive(const TSharedRef<FArchive, ESPMode::ThreadSafe>& InArchive, FVlcMediaPlayerChunkCache::FSource& InSource)
+	: Archive(InArchive)
+	, Position(0)
+	, Source(InSource)
+{
+	SetIsLoading(true);
+}
+
+
+FVlcMediaPlayerCachedArchive::~FVlcMediaPlayerCachedArchive()
+{
+	FVlcMediaPlayerChunkCache::Get().ReleaseSource(Source);
+}
+
+
+/* FArchive interface
+ *****************************************************************************/
+
+FString FVlcMediaPlayerCachedArchive::GetArchiveName() const
+{
+	return Source.Url;
+}
+
+
+void FVlcMediaPlayerCachedArchive::Seek(int64 InPos)
+{
+	Position = FMath::Clamp<int64>(InPos, 0, Source.Size);
+}
+
+
+void FVlcMediaPlayerCachedArchive::Serialize(void* Data, int64 Num)
+{
+	if (Position + Num > Source.Size)
+	{
+		SetError();
+		return;
+	}
+
+	uint8* Buffer = (uint8*)Data;
+
+	while (Num > 0)
+	{
+		const int64 ChunkIndex = Position / FVlcMediaPlayerChunkCache::ChunkSize;
+		const int64 ChunkOffset = ChunkIndex * FVlcMediaPlayerChunkCache::ChunkSize;
+
+		TSharedPtr<FVlcMediaPlayerChunkCache::FChunk, ESPMode::ThreadSafe> Chunk = FVlcMediaPlayerChunkCache::Get().GetChunk(Source, ChunkIndex, [this, ChunkOffset](TArray<uint8>& ChunkData)
+		{
+			ChunkData.SetNumUninitialized((int32)FMath::Min(FVlcMediaPlayerChunkCache::ChunkSize, Source.Size - ChunkOffset));
+
+			Archive->Seek(ChunkOffset);
+			Archive->Serialize(ChunkData.GetData(), ChunkData.Num());
+
+			if (Archive->IsError())
+			{
+				UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Failed to load chunk at offset %lli of %s"), ChunkOffset, *Source.Url);
+
+				Archive->ClearError();
+				return false;
+			}
+
+			return true;
+		});
+
+		if (!Chunk.IsValid())
+		{
+			SetError();
+			return;
+		}
+
+		const int64 BytesToCopy = FMath::Min(Num, ChunkOffset + Chunk->Data.Num() - Position);
+
+		if (BytesToCopy <= 0)
+		{
+			SetError(); // archive is shorter than reported
+			return;
+		}
+
+		FMemory::Memcpy(Buffer, Chunk->Data.GetData() + (Position - ChunkOffset), BytesToCopy);
+
+		Buffer += BytesToCopy;
+		Num -= BytesToCopy;
+		Position += BytesToCopy;
+	}
+}
+
+
+int64 FVlcMediaPlayerCachedArchive::Tell()
+{
+	return Position;
+}
+
+
+int64 FVlcMediaPlayerCachedArchive::TotalSize()
+{
+	return Source.Size;
+}
@@ -0,0 +1,53 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Serialization/Archive.h"
+#include "Templates/SharedPointer.h"
+
+#include "VlcMediaPlayerChunkCache.h"
+
+
+/**
+ * Reads an archive through the shared chunk cache.
+ *
+ * The archive must be used by a single thread at a time.
+ */
+class FVlcMediaPlayerCachedArchive
+	: public FArchive
+{
+public:
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InArchive The archive that chunks are loaded from.
+	 * @param InSource The source that the archive was registered as with the chunk cache.
+	 */
+	FVlcMediaPlayerCachedArchive(const TSharedRef<FArchive, ESPMode::ThreadSafe>& InArchive, FVlcMediaPlayerChunkCache::FSource& InSource);
+
+	/** Virtual destructor. */
+	virtual ~FVlcMediaPlayerCachedArchive();
+
+public:
+
+	//~ FArchive interface
+
+	virtual FString GetArchiveName() const override;
+	virtual void Seek(int64 InPos) override;
+	virtual void Serialize(void* Data, int64 Num) override;
+	virtual int64 Tell() override;
+	virtual int64 TotalSize() override;
+
+private:
+
+	/** The archive that chunks are loaded from. */
+	TSharedRef<FArchive, ESPMode::ThreadSafe> Archive;
+
+	/** The current read position. */
+	int64 Position;
+
+	/** The source that the archive was registered as (released when the archive is destroyed). */
+	FVlcMediaPlayerChunkCache::FSource& Source;
+};
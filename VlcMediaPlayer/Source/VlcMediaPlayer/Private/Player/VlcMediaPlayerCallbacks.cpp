@@ -7,58 +7,252 @@
 #include "IMediaOptions.h"
 #include "IMediaTextureSample.h"
 #include "MediaSamples.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/Class.h"
 
 #include "VlcMediaPlayerAudioSample.h"
+#include "VlcMediaPlayerSamples.h"
 #include "VlcMediaPlayerTextureSample.h"
 
 #include "VlcWrapper.h"
 
+
+/* Local helpers
+ *****************************************************************************/
+
+namespace VlcMediaPlayerCallbacks
+{
+	/** Longest time to wait for queued audio to be consumed when VLC drains audio output (in seconds). */
+	const double AudioDrainTimeout = 2.0;
+
+	/** Amount of audio that the audio ring buffer holds (in seconds). */
+	const double AudioRingDuration = 1.0;
+
+	/** Frame rate to assume until the video's frame rate is known. */
+	const double DefaultFrameRate = 30.0;
+
+	/** Weight of a new frame interval in the smoothed video frame duration. */
+	const double FrameDurationSmoothing = 0.125;
+
+	/** Longest interval between displayed frames that counts towards the frame duration. */
+	const FTimespan MaxFrameInterval = FTimespan::FromSeconds(1.0);
+
+	/** Shortest interval between displayed frames that counts towards the frame duration. */
+	const FTimespan MinFrameInterval = FTimespan::FromMilliseconds(1.0);
+
+	/** Number of displayed frames after which the video callbacks must no longer allocate memory. */
+	const uint32 SteadyStateFrames = 30;
+
+	/** Check whether the given chroma is 8-bit YUV with both chroma dimensions subsampled by two. */
+	bool IsPlanar420(const vlc_chroma_description_t& ChromaDescr)
+	{
+		if ((ChromaDescr.pixel_size != 1) || (ChromaDescr.plane_count < 2) || (ChromaDescr.plane_count > 3))
+		{
+			return false;
+		}
+
+		const bool HalfHeight = (ChromaDescr.p[1].h.num * 2 == ChromaDescr.p[1].h.den);
+
+		if (ChromaDescr.plane_count == 2)
+		{
+			return HalfHeight; // semi-planar chroma, i.e. NV12 or NV21
+		}
+
+		return HalfHeight && (ChromaDescr.p[1].w.num * 2 == ChromaDescr.p[1].w.den);
+	}
+
+	/** Point VLC's plane pointers at the planes that follow the first plane of a buffer. */
+	void SetPlanePointers(const FVlcMediaPlayerPlaneLayout& Layout, void** Planes)
+	{
+		for (uint32 Plane = 1; Plane < Layout.NumPlanes; ++Plane)
+		{
+			Planes[Plane] = (uint8*)Planes[0] + Layout.GetPlaneOffset(Plane);
+		}
+	}
+}
+
+
 /* FVlcMediaOutput structors
  *****************************************************************************/
 
 FVlcMediaPlayerCallbacks::FVlcMediaPlayerCallbacks()
 	: AudioChannels(0)
-	, AudioSampleFormat(EMediaAudioSampleFormat::Int16)
-	, AudioSamplePool(new FVlcMediaAudioSamplePool)
+	, AudioDrainAborted(false)
+	, AudioPaused(false)
+	, AudioSampleFormat(EMediaAudioSampleFormat::Float)
 	, AudioSampleRate(0)
 	, AudioSampleSize(0)
+	, CurrentRate(0.0f)
 	, CurrentTime(FTimespan::Zero())
+	, CurrentTimeClock(0)
 	, Player(nullptr)
-	, Samples(new FMediaSamples)
+	, ResumeRate(0.0f)
+	, Samples(new FVlcMediaPlayerSamples)
+	, VideoAllocations(0)
 	, VideoBufferDim(FIntPoint::ZeroValue)
-	, VideoBufferStride(0)
+	, VideoConversionCycles(0)
+	, VideoConversionPixels(0)
+	, VideoConverterEnabled(false)
+	, VideoDiscardBuffer(nullptr)
+	, VideoDiscardBufferSize(0)
 	, VideoFrameDuration(FTimespan::Zero())
+	, VideoFrameRate(0.0f)
+	, VideoFramesSinceSetup(0)
+	, VideoLastLoopSeam(0)
+	, VideoLoopSeamPending(false)
+	, VideoLoopSeams(0)
+	, VideoMaxLoopSeam(0)
+	, VideoMaxOutputDim(FIntPoint::ZeroValue)
+	, VideoNominalFrameRate(0.0f)
+	, VideoPoolDrops(0)
+	, VideoOutput(EVlcMediaPlayerVideoOutput::Packed)
 	, VideoOutputDim(FIntPoint::ZeroValue)
-	, VideoPreviousTime(FTimespan::MinValue())
+	, VideoPreviousDisplayClock(-1)
+	, VideoPreviousDisplayTime(FTimespan::MinValue())
 	, VideoSampleFormat(EMediaTextureSampleFormat::CharAYUV)
+	, VideoRecentIntervalIndex(0)
 	, VideoSamplePool(new FVlcMediaTextureSamplePool)
-{ }
+	, VideoSamplePoolLimit(0)
+	, VideoSteadyStateAllocations(0)
+{
+	FMemory::Memzero(VideoRecentIntervals);
+}
 
 
 FVlcMediaPlayerCallbacks::~FVlcMediaPlayerCallbacks()
 {
 	Shutdown();
 
-	delete AudioSamplePool;
-	AudioSamplePool = nullptr;
-
 	delete Samples;
 	Samples = nullptr;
 
 	delete VideoSamplePool;
 	VideoSamplePool = nullptr;
+
+	if (VideoDiscardBuffer != nullptr)
+	{
+		FMemory::Free(VideoDiscardBuffer);
+		VideoDiscardBuffer = nullptr;
+		VideoDiscardBufferSize = 0;
+	}
 }
 
 
 /* FVlcMediaOutput interface
  *****************************************************************************/
 
+void FVlcMediaPlayerCallbacks::Configure(const FVideoSettings& Settings)
+{
+	VideoMaxOutputDim = Settings.MaxOutputDim;
+	VideoOutput = Settings.Output;
+
+	ConfigureQueue(Settings);
+}
+
+
+void FVlcMediaPlayerCallbacks::Configure(const FVlcMediaPlayerCallbacks& Other)
+{
+	VideoMaxOutputDim = Other.VideoMaxOutputDim;
+	VideoOutput = Other.VideoOutput;
+
+	VideoQueue.Configure(Other.VideoQueue.GetDepth(), Other.VideoQueue.GetPolicy());
+	VideoConversionCycles = 0;
+	VideoConversionPixels = 0;
+	VideoPoolDrops = 0;
+	VideoSamplePoolLimit = Other.VideoSamplePoolLimit.load();
+}
+
+
+void FVlcMediaPlayerCallbacks::ConfigureQueue(const FVideoSettings& Settings)
+{
+	VideoQueue.Configure(FMath::Clamp(Settings.QueueDepth, 1, 32), Settings.QueuePolicy);
+	VideoConversionCycles = 0;
+	VideoConversionPixels = 0;
+	VideoPoolDrops = 0;
+
+	// samples may be pending, queued for output, held by the renderer or locked by VLC
+	VideoSamplePoolLimit = 2 * VideoQueue.GetDepth() + 2;
+}
+
+
+void FVlcMediaPlayerCallbacks::FlushSamples()
+{
+	AudioDrainAborted = true;
+	VideoQueue.Flush();
+	Samples->FlushSamples();
+}
+
+
+int32 FVlcMediaPlayerCallbacks::ForwardVideoSamples()
+{
+	TSharedPtr<FVlcMediaPlayerTextureSample, ESPMode::ThreadSafe> Sample;
+	int32 NumForwarded = 0;
+
+	while ((Samples->NumVideoSamples() < VideoQueue.GetDepth()) && VideoQueue.Dequeue(Sample))
+	{
+		Samples->AddVideo(Sample.ToSharedRef());
+		++NumForwarded;
+	}
+
+	return NumForwarded;
+}
+
+
+bool FVlcMediaPlayerCallbacks::HasVideoOutput(const FVideoSettings& Settings) const
+{
+	return (VideoMaxOutputDim == Settings.MaxOutputDim) && (VideoOutput == Settings.Output);
+}
+
+
 IMediaSamples& FVlcMediaPlayerCallbacks::GetSamples()
 {
 	return *Samples;
 }
 
 
+FString FVlcMediaPlayerCallbacks::GetStats() const
+{
+	FString StatsString;
+	{
+		StatsString += TEXT("Audio Callbacks\n");
+		StatsString += FString::Printf(TEXT("    Overruns: %i\n"), AudioRing.GetNumOverruns());
+		StatsString += FString::Printf(TEXT("    Underruns: %i\n"), AudioRing.GetNumUnderruns());
+		StatsString += TEXT("\n");
+	}
+
+	{
+		StatsString += TEXT("Video Callbacks\n");
+		StatsString += FString::Printf(TEXT("    Allocations: %i\n"), VideoAllocations.load());
+		StatsString += FString::Printf(TEXT("    Steady State Allocations: %i\n"), VideoSteadyStateAllocations.load());
+		StatsString += FString::Printf(TEXT("    Frame Rate: %.3f\n"), VideoFrameRate.load());
+		StatsString += FString::Printf(TEXT("    Queue Depth: %i\n"), VideoQueue.GetDepth());
+		StatsString += FString::Printf(TEXT("    Dropped Frames (Queue Full): %i\n"), VideoQueue.GetNumDropped());
+		StatsString += FString::Printf(TEXT("    Dropped Frames (Pool Exhausted): %i\n"), VideoPoolDrops.load());
+		StatsString += FString::Printf(TEXT("    Loops: %i\n"), VideoLoopSeams.load());
+		StatsString += FString::Printf(TEXT("    Last Loop Seam: %.1f ms\n"), VideoLastLoopSeam.load() / 1000.0);
+		StatsString += FString::Printf(TEXT("    Max Loop Seam: %.1f ms\n"), VideoMaxLoopSeam.load() / 1000.0);
+
+		const double ConversionSeconds = FPlatformTime::ToSeconds64(VideoConversionCycles.load());
+
+		if (ConversionSeconds > 0.0)
+		{
+			StatsString += FString::Printf(TEXT("    Conversion Kernel: %s\n"), FVlcMediaPlayerColorConverter::GetKernelName());
+			StatsString += FString::Printf(TEXT("    Conversion Rate: %.1f MPixels/s\n"), VideoConversionPixels.load() / ConversionSeconds / 1000000.0);
+		}
+		StatsString += TEXT("\n");
+	}
+
+	return StatsString;
+}
+
+
+float FVlcMediaPlayerCallbacks::GetVideoFrameRate() const
+{
+	return VideoFrameRate.load();
+}
+
+
 void FVlcMediaPlayerCallbacks::Initialize(libvlc_media_player_t& InPlayer)
 {
 	Shutdown();
@@ -95,6 +289,46 @@ void FVlcMediaPlayerCallbacks::Initialize(libvlc_media_player_t& InPlayer)
 		&FVlcMediaPlayerCallbacks::StaticVideoDisplayCallback,
 		this
 	);
+
+	AudioDrainAborted = false;
+}
+
+
+void FVlcMediaPlayerCallbacks::MarkLoopSeam()
+{
+	VideoLoopSeamPending = true;
+}
+
+
+void FVlcMediaPlayerCallbacks::Restart()
+{
+	FlushSamples();
+	AudioDrainAborted = false;
+
+	FScopeLock Lock(&CurrentTimeCriticalSection);
+	AudioPaused = false;
+}
+
+
+void FVlcMediaPlayerCallbacks::SetCurrentTime(FTimespan Time, float Rate)
+{
+	FScopeLock Lock(&CurrentTimeCriticalSection);
+
+	if (Rate != 0.0f)
+	{
+		ResumeRate = Rate;
+	}
+
+	// the player's state lags behind VLC's audio output, which stays paused until it resumes
+	CurrentRate = AudioPaused ? 0.0f : Rate;
+	CurrentTime = Time;
+	CurrentTimeClock = libvlc_clock();
+}
+
+
+void FVlcMediaPlayerCallbacks::SetNominalVideoFrameRate(float FrameRate)
+{
+	VideoNominalFrameRate = FMath::Max(FrameRate, 0.0f);
 }
 
 
@@ -106,24 +340,226 @@ void FVlcMediaPlayerCallbacks::Shutdown()
 	}
 
 	// unregister callbacks
+	AudioDrainAborted = true;
+	Samples->NotifyAudioConsumed();
+
 	libvlc_audio_set_callbacks(Player, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
 	libvlc_audio_set_format_callbacks(Player, nullptr, nullptr);
 
 	libvlc_video_set_callbacks(Player, nullptr, nullptr, nullptr, nullptr);
 	libvlc_video_set_format_callbacks(Player, nullptr, nullptr);
 
-	AudioSamplePool->Reset();
+	AudioRing.Reset();
+	VideoQueue.Flush();
 	VideoSamplePool->Reset();
 
-	CurrentTime = FTimespan::Zero();
+	{
+		FScopeLock Lock(&CurrentTimeCriticalSection);
+		AudioPaused = false;
+		ResumeRate = 0.0f;
+	}
+
+	SetCurrentTime(FTimespan::Zero(), 0.0f);
+	VideoFrameRate = 0.0f;
+	VideoNominalFrameRate = 0.0f;
 
 	Player = nullptr;
 }
 
 
+/* FVlcMediaOutput implementation
+*****************************************************************************/
+
+FTimespan FVlcMediaPlayerCallbacks::TimestampToTime(int64 Timestamp) const
+{
+	FScopeLock Lock(&CurrentTimeCriticalSection);
+	return CurrentTime + FTimespan::FromMicroseconds((double)(Timestamp - CurrentTimeClock) * CurrentRate);
+}
+
+
+void* FVlcMediaPlayerCallbacks::LockDiscardBuffer(void** Planes)
+{
+	// VLC currently requires a valid buffer or it will crash
+	Planes[0] = VideoDiscardBuffer;
+	VlcMediaPlayerCallbacks::SetPlanePointers(VideoPlanes, Planes);
+
+	return nullptr;
+}
+
+
+void FVlcMediaPlayerCallbacks::PauseTime(int64 Timestamp)
+{
+	FScopeLock Lock(&CurrentTimeCriticalSection);
+
+	if (AudioPaused)
+	{
+		return;
+	}
+
+	CurrentTime += FTimespan::FromMicroseconds((double)(Timestamp - CurrentTimeClock) * CurrentRate);
+	CurrentTimeClock = Timestamp;
+	CurrentRate = 0.0f;
+	AudioPaused = true;
+}
+
+
+void FVlcMediaPlayerCallbacks::ResumeTime(int64 Timestamp)
+{
+	FScopeLock Lock(&CurrentTimeCriticalSection);
+
+	if (!AudioPaused)
+	{
+		return;
+	}
+
+	// continue from the frozen time, even if the player didn't report playing yet
+	CurrentRate = ResumeRate;
+	CurrentTimeClock = Timestamp;
+	AudioPaused = false;
+}
+
+
+void FVlcMediaPlayerCallbacks::TrackVideoAllocation()
+{
+	++VideoAllocations;
+
+	if (VideoFramesSinceSetup >= VlcMediaPlayerCallbacks::SteadyStateFrames)
+	{
+		++VideoSteadyStateAllocations;
+		ensureMsgf(false, TEXT("VLC video callbacks allocated memory after %u frames"), VideoFramesSinceSetup);
+	}
+}
+
+
+void FVlcMediaPlayerCallbacks::UpdateLoopSeam(int64 Timestamp)
+{
+	if (VideoPreviousDisplayClock >= 0)
+	{
+		VideoRecentIntervals[VideoRecentIntervalIndex++ % NumRecentIntervals] = Timestamp - VideoPreviousDisplayClock;
+	}
+
+	VideoPreviousDisplayClock = Timestamp;
+
+	if (!VideoLoopSeamPending.exchange(false))
+	{
+		return;
+	}
+
+	// the wrap-around is reported asynchronously, so the gap may be a few frames back
+	int64 LongestInterval = 0;
+
+	for (const int64 Interval : VideoRecentIntervals)
+	{
+		LongestInterval = FMath::Max(LongestInterval, Interval);
+	}
+
+	FMemory::Memzero(VideoRecentIntervals);
+
+	const int64 Seam = FMath::Max<int64>(0, LongestInterval - VideoFrameDuration.GetTicks() / ETimespan::TicksPerMicrosecond);
+
+	VideoLastLoopSeam = Seam;
+	VideoMaxLoopSeam = FMath::Max(VideoMaxLoopSeam.load(), Seam);
+	++VideoLoopSeams;
+
+	UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Callbacks %llx: Loop seam of %.1f ms (frame duration %.1f ms)"), this, Seam / 1000.0, VideoFrameDuration.GetTotalMilliseconds());
+}
+
+
+void FVlcMediaPlayerCallbacks::UpdateVideoFrameDuration(FTimespan Time)
+{
+	const FTimespan PreviousTime = VideoPreviousDisplayTime;
+	VideoPreviousDisplayTime = Time;
+
+	if (PreviousTime == FTimespan::MinValue())
+	{
+		return;
+	}
+
+	const FTimespan Interval = Time - PreviousTime;
+
+	// ignore pauses, seeks and stalls
+	if ((Interval < VlcMediaPlayerCallbacks::MinFrameInterval) || (Interval > VlcMediaPlayerCallbacks::MaxFrameInterval))
+	{
+		return;
+	}
+
+	// smooth out jitter while following frame rate changes
+	const double Ticks = FMath::Lerp((double)VideoFrameDuration.GetTicks(), (double)Interval.GetTicks(), VlcMediaPlayerCallbacks::FrameDurationSmoothing);
+
+	VideoFrameDuration = FTimespan((int64)Ticks);
+	VideoFrameRate = (float)(1.0 / VideoFrameDuration.GetTotalSeconds());
+}
+
+
 /* FVlcMediaOutput static functions
 *****************************************************************************/
 
+FVlcMediaPlayerCallbacks::FVideoSettings FVlcMediaPlayerCallbacks::GetVideoSettings(const IMediaOptions* Options)
+{
+	const auto Settings = GetDefault<UVlcMediaPlayerSettings>();
+
+	FVideoSettings VideoSettings;
+	{
+		VideoSettings.MaxOutputDim = Settings->MaxVideoOutputSize;
+		VideoSettings.Output = Settings->VideoOutput;
+		VideoSettings.QueueDepth = Settings->VideoQueueDepth;
+		VideoSettings.QueuePolicy = Settings->VideoQueuePolicy;
+	}
+
+	if (Options == nullptr)
+	{
+		return VideoSettings;
+	}
+
+	// video output
+	VideoSettings.MaxOutputDim.X = (int32)Options->GetMediaOption("MaxVideoOutputWidth", (int64)VideoSettings.MaxOutputDim.X);
+	VideoSettings.MaxOutputDim.Y = (int32)Options->GetMediaOption("MaxVideoOutputHeight", (int64)VideoSettings.MaxOutputDim.Y);
+
+	const FString VideoOutputOption = Options->GetMediaOption("VideoOutput", FString());
+
+	if (VideoOutputOption == TEXT("Packed"))
+	{
+		VideoSettings.Output = EVlcMediaPlayerVideoOutput::Packed;
+	}
+	else if (VideoOutputOption == TEXT("NativePlanar"))
+	{
+		VideoSettings.Output = EVlcMediaPlayerVideoOutput::NativePlanar;
+	}
+	else if (VideoOutputOption == TEXT("Bgra"))
+	{
+		VideoSettings.Output = EVlcMediaPlayerVideoOutput::Bgra;
+	}
+	else if (!VideoOutputOption.IsEmpty())
+	{
+		UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Unknown VideoOutput option '%s'"), *VideoOutputOption);
+	}
+
+	// video sample queue
+	VideoSettings.QueueDepth = (int32)Options->GetMediaOption("VideoQueueDepth", (int64)VideoSettings.QueueDepth);
+
+	const FString QueuePolicyOption = Options->GetMediaOption("VideoQueuePolicy", FString());
+
+	if (QueuePolicyOption == TEXT("DropOldest"))
+	{
+		VideoSettings.QueuePolicy = EVlcMediaPlayerQueuePolicy::DropOldest;
+	}
+	else if (QueuePolicyOption == TEXT("DropNewest"))
+	{
+		VideoSettings.QueuePolicy = EVlcMediaPlayerQueuePolicy::DropNewest;
+	}
+	else if (QueuePolicyOption == TEXT("Mailbox"))
+	{
+		VideoSettings.QueuePolicy = EVlcMediaPlayerQueuePolicy::Mailbox;
+	}
+	else if (!QueuePolicyOption.IsEmpty())
+	{
+		UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Unknown VideoQueuePolicy option '%s'"), *QueuePolicyOption);
+	}
+
+	return VideoSettings;
+}
+
+
 void FVlcMediaPlayerCallbacks::StaticAudioCleanupCallback(void* Opaque)
 {
 	UE_LOG(LogVlcMediaPlayer, VeryVerbose, TEXT("Callbacks %llx: StaticAudioCleanupCallback"), Opaque);
@@ -133,12 +569,49 @@ void FVlcMediaPlayerCallbacks::StaticAudioCleanupCallback(void* Opaque)
 void FVlcMediaPlayerCallbacks::StaticAudioDrainCallback(void* Opaque)
 {
 	UE_LOG(LogVlcMediaPlayer, VeryVerbose, TEXT("Callbacks %llx: StaticAudioDrainCallback"), Opaque);
+
+	auto Callbacks = (FVlcMediaPlayerCallbacks*)Opaque;
+
+	if (Callbacks == nullptr)
+	{
+		return;
+	}
+
+	// VLC waits for the drain to complete, so block until the queued samples were consumed
+	const double Deadline = FPlatformTime::Seconds() + VlcMediaPlayerCallbacks::AudioDrainTimeout;
+
+	while ((Callbacks->Samples->NumAudio() > 0) && !Callbacks->AudioDrainAborted)
+	{
+		const double RemainingTime = Deadline - FPlatformTime::Seconds();
+
+		if ((RemainingTime <= 0.0) || !Callbacks->Samples->WaitForAudioConsumed((uint32)FMath::CeilToInt(RemainingTime * 1000.0)))
+		{
+			break;
+		}
+	}
 }
 
 
 void FVlcMediaPlayerCallbacks::StaticAudioFlushCallback(void* Opaque, int64 Timestamp)
 {
 	UE_LOG(LogVlcMediaPlayer, VeryVerbose, TEXT("Callbacks %llx: StaticAudioFlushCallback"), Opaque);
+
+	auto Callbacks = (FVlcMediaPlayerCallbacks*)Opaque;
+
+	if (Callbacks == nullptr)
+	{
+		return;
+	}
+
+	// VLC won't deliver more samples until the flush completed, so all queued samples are stale
+	TSharedPtr<IMediaAudioSample, ESPMode::ThreadSafe> StaleSample;
+
+	while (Callbacks->Samples->FetchAudio(TRange<FTimespan>::All(), StaleSample))
+	{
+		StaleSample.Reset();
+	}
+
+	Callbacks->AudioRing.Interrupt();
 }
 
 
@@ -146,7 +619,13 @@ void FVlcMediaPlayerCallbacks::StaticAudioPauseCallback(void* Opaque, int64 Time
 {
 	UE_LOG(LogVlcMediaPlayer, VeryVerbose, TEXT("Callbacks %llx: StaticAudioPauseCallback (Timestamp = %i)"), Opaque, Timestamp);
 
-	// do nothing; pausing is handled in Update
+	auto Callbacks = (FVlcMediaPlayerCallbacks*)Opaque;
+
+	if (Callbacks != nullptr)
+	{
+		Callbacks->AudioRing.Interrupt();
+		Callbacks->PauseTime(Timestamp);
+	}
 }
 
 
@@ -166,24 +645,25 @@ void FVlcMediaPlayerCallbacks::StaticAudioPlayCallback(void* Opaque, const void*
 		Callbacks->Samples->NumAudio()
 	);
 
-	// create & add sample to queue
-	auto AudioSample = Callbacks->AudioSamplePool->AcquireShared();
-
-	const FTimespan Delay = FTimespan::FromMicroseconds(Timestamp - clock());
-	const FTimespan Duration = FTimespan::FromMicroseconds((Count * 1000000) / Callbacks->AudioSampleRate);
+	// copy frames into ring buffer & add sample to queue
+	const FTimespan Time = Callbacks->TimestampToTime(Timestamp);
+	const FTimespan Duration = FTimespan::FromMicroseconds(((int64)Count * 1000000) / Callbacks->AudioSampleRate);
 	const SIZE_T SamplesSize = Count * Callbacks->AudioSampleSize * Callbacks->AudioChannels;
 
-	if (AudioSample->Initialize(
+	const TSharedPtr<FVlcMediaPlayerAudioSample, ESPMode::ThreadSafe> AudioSample = Callbacks->AudioRing.Write(
 		Samples,
 		SamplesSize,
 		Count,
 		Callbacks->AudioChannels,
 		Callbacks->AudioSampleFormat,
 		Callbacks->AudioSampleRate,
-		Callbacks->CurrentTime + Delay,
-		Duration))
+		Time,
+		Duration
+	);
+
+	if (AudioSample.IsValid())
 	{
-		Callbacks->Samples->AddAudio(AudioSample);
+		Callbacks->Samples->AddAudio(AudioSample.ToSharedRef());
 	}
 }
 
@@ -192,7 +672,12 @@ void FVlcMediaPlayerCallbacks::StaticAudioResumeCallback(void* Opaque, int64 Tim
 {
 	UE_LOG(LogVlcMediaPlayer, VeryVerbose, TEXT("Callbacks %llx: StaticAudioResumeCallback (Timestamp = %i)"), Opaque, Timestamp);
 
-	// do nothing; resuming is handled in Update
+	auto Callbacks = (FVlcMediaPlayerCallbacks*)Opaque;
+
+	if (Callbacks != nullptr)
+	{
+		Callbacks->ResumeTime(Timestamp);
+	}
 }
 
 
@@ -212,55 +697,27 @@ int FVlcMediaPlayerCallbacks::StaticAudioSetupCallback(void** Opaque, ANSICHAR*
 		*Channels
 	);
 
-	// setup audio format
-	if (*Channels > 8)
+	// keep native rate & channel layout; the engine mixes 32-bit float natively
+	if (*Channels > MaxAudioChannels)
 	{
-		*Channels = 8;
+		*Channels = MaxAudioChannels;
 	}
 
-	if (FMemory::Memcmp(Format, "S8  ", 4) == 0)
-	{
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Int8;
-		Callbacks->AudioSampleSize = 1;
-	}
-	else if (FMemory::Memcmp(Format, "S16N", 4) == 0)
-	{
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Int16;
-		Callbacks->AudioSampleSize = 2;
-	}
-	else if (FMemory::Memcmp(Format, "S32N", 4) == 0)
-	{
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Int32;
-		Callbacks->AudioSampleSize = 4;
-	}
-	else if (FMemory::Memcmp(Format, "FL32", 4) == 0)
-	{
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Float;
-		Callbacks->AudioSampleSize = 4;
-	}
-	else if (FMemory::Memcmp(Format, "FL64", 4) == 0)
-	{
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Double;
-		Callbacks->AudioSampleSize = 8;
-	}
-	else if (FMemory::Memcmp(Format, "U8  ", 4) == 0)
-	{
-		// unsigned integer fall back
-		FMemory::Memcpy(Format, "S8  ", 4);
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Int8;
-		Callbacks->AudioSampleSize = 1;
-	}
-	else
-	{
-		// unsupported format fall back
-		FMemory::Memcpy(Format, "S16N", 4);
-		Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Int16;
-		Callbacks->AudioSampleSize = 2;
-	}
+	FMemory::Memcpy(Format, "FL32", 4);
+
+	Callbacks->AudioSampleFormat = EMediaAudioSampleFormat::Float;
+	Callbacks->AudioSampleSize = 4;
 
 	Callbacks->AudioChannels = *Channels;
 	Callbacks->AudioSampleRate = *Rate;
 
+	// allocate ring buffer storage
+	Callbacks->AudioRing.Configure(*Rate * *Channels * Callbacks->AudioSampleSize, VlcMediaPlayerCallbacks::AudioRingDuration);
+
+	// a new audio stream starts unpaused
+	FScopeLock Lock(&Callbacks->CurrentTimeCriticalSection);
+	Callbacks->AudioPaused = false;
+
 	return 0;
 }
 
@@ -276,20 +733,35 @@ void FVlcMediaPlayerCallbacks::StaticVideoDisplayCallback(void* Opaque, void* Pi
 	auto Callbacks = (FVlcMediaPlayerCallbacks*)Opaque;
 	auto VideoSample = (FVlcMediaPlayerTextureSample*)Picture;
 
-	if ((Callbacks == nullptr) || (VideoSample == nullptr))
+	if (Callbacks == nullptr)
+	{
+		return;
+	}
+
+	// VLC calls the display callback at the picture's presentation date
+	const int64 Timestamp = libvlc_clock();
+	const FTimespan Time = Callbacks->TimestampToTime(Timestamp);
+
+	// skipped frames still count towards the frame rate
+	Callbacks->UpdateLoopSeam(Timestamp);
+	Callbacks->UpdateVideoFrameDuration(Time);
+
+	if (VideoSample == nullptr)
 	{
 		return;
 	}
 
-	UE_LOG(LogVlcMediaPlayer, VeryVerbose, TEXT("Callbacks %llx: StaticVideoDisplayCallback (CurrentTime = %s, Queue = %i)"),
-		Opaque, *Callbacks->CurrentTime.ToString(),
+	UE_LOG(LogVlcMediaPlayer, VeryVerbose, TEXT("Callbacks %llx: StaticVideoDisplayCallback (Time = %s, Queue = %i)"),
+		Opaque, *Time.ToString(),
 		Callbacks->Samples->NumVideoSamples()
 	);
 
-	VideoSample->SetTime(Callbacks->CurrentTime);
+	VideoSample->SetDuration(Callbacks->VideoFrameDuration);
+	VideoSample->SetTime(Time);
 
-	// add sample to queue
-	Callbacks->Samples->AddVideo(Callbacks->VideoSamplePool->ToShared(VideoSample));
+	// add sample to queue (forwarded to the output on the game thread)
+	Callbacks->VideoQueue.Enqueue(Callbacks->VideoSamplePool->ToShared(VideoSample));
+	++Callbacks->VideoFramesSinceSetup;
 }
 
 
@@ -300,43 +772,55 @@ void* FVlcMediaPlayerCallbacks::StaticVideoLockCallback(void* Opaque, void** Pla
 
 	FMemory::Memzero(Planes, 5 * sizeof(void*));
 
-	// skip if already processed
-	if (Callbacks->VideoPreviousTime == Callbacks->CurrentTime)
+	UE_LOG(LogVlcMediaPlayer, VeryVerbose, TEXT("Callbacks %llx: StaticVideoLockCallback"), Opaque);
+
+	// skip if the frame would be dropped anyway
+	if (Callbacks->VideoQueue.RejectNewSample())
 	{
-		// VLC currently requires a valid buffer or it will crash
-		Planes[0] = FMemory::Malloc(Callbacks->VideoBufferStride * Callbacks->VideoBufferDim.Y, 32);
-		return nullptr;
+		return Callbacks->LockDiscardBuffer(Planes);
 	}
 
-	UE_LOG(LogVlcMediaPlayer, VeryVerbose, TEXT("Callbacks %llx: StaticVideoLockCallback (CurrentTime = %s)"),
-		Opaque,
-		*Callbacks->CurrentTime.ToString()
-	);
-
 	// create & initialize video sample
-	auto VideoSample = Callbacks->VideoSamplePool->Acquire();
+	bool Allocated = false;
+	auto VideoSample = Callbacks->VideoSamplePool->Acquire(Callbacks->VideoSamplePoolLimit, Allocated);
 
 	if (VideoSample == nullptr)
 	{
-		// VLC currently requires a valid buffer or it will crash
-		Planes[0] = FMemory::Malloc(Callbacks->VideoBufferStride * Callbacks->VideoBufferDim.Y, 32);
-		return nullptr;
+		++Callbacks->VideoPoolDrops;
+		return Callbacks->LockDiscardBuffer(Planes);
+	}
+
+	if (Allocated)
+	{
+		Callbacks->TrackVideoAllocation();
+	}
+
+	if (VideoSample->GetBufferSize() < Callbacks->VideoSamplePlanes.GetBufferSize())
+	{
+		Callbacks->TrackVideoAllocation();
 	}
 
 	if (!VideoSample->Initialize(
 		Callbacks->VideoBufferDim,
 		Callbacks->VideoOutputDim,
 		Callbacks->VideoSampleFormat,
-		Callbacks->VideoBufferStride,
+		Callbacks->VideoSamplePlanes,
 		Callbacks->VideoFrameDuration))
 	{
-		// VLC currently requires a valid buffer or it will crash
-		Planes[0] = FMemory::Malloc(Callbacks->VideoBufferStride * Callbacks->VideoBufferDim.Y, 32);
-		return nullptr;
+		Callbacks->VideoSamplePool->Release(VideoSample);
+		return Callbacks->LockDiscardBuffer(Planes);
 	}
 
-	Callbacks->VideoPreviousTime = Callbacks->CurrentTime;
-	Planes[0] = VideoSample->GetMutableBuffer();
+	if (Callbacks->VideoConverterEnabled)
+	{
+		// VLC decodes into the staging buffer; the sample is filled in the unlock callback
+		Callbacks->LockDiscardBuffer(Planes);
+	}
+	else
+	{
+		Planes[0] = VideoSample->GetMutableBuffer();
+		VlcMediaPlayerCallbacks::SetPlanePointers(Callbacks->VideoPlanes, Planes);
+	}
 
 	return VideoSample; // passed as Picture into unlock & display callbacks
 
@@ -364,7 +848,8 @@ unsigned FVlcMediaPlayerCallbacks::StaticVideoSetupCallback(void** Opaque, char*
 	{
 		Callbacks->VideoBufferDim = FIntPoint::ZeroValue;
 		Callbacks->VideoOutputDim = FIntPoint::ZeroValue;
-		Callbacks->VideoBufferStride = 0;
+		Callbacks->VideoPlanes.Reset();
+		Callbacks->VideoSamplePlanes.Reset();
 
 		return 0;
 	}
@@ -374,18 +859,50 @@ unsigned FVlcMediaPlayerCallbacks::StaticVideoSetupCallback(void** Opaque, char*
 		return 0;
 	}
 
+	// scale down to the maximum output size
+	const FIntPoint MaxDim = Callbacks->VideoMaxOutputDim;
+
+	if (((MaxDim.X > 0) && (Callbacks->VideoOutputDim.X > MaxDim.X)) || ((MaxDim.Y > 0) && (Callbacks->VideoOutputDim.Y > MaxDim.Y)))
+	{
+		const double ScaleX = (MaxDim.X > 0) ? (double)MaxDim.X / Callbacks->VideoOutputDim.X : 1.0;
+		const double ScaleY = (MaxDim.Y > 0) ? (double)MaxDim.Y / Callbacks->VideoOutputDim.Y : 1.0;
+		const double Scale = FMath::Min(ScaleX, ScaleY);
+
+		// chroma subsampling requires even dimensions
+		const FIntPoint ScaledDim(
+			FMath::Max(2, FMath::FloorToInt(Callbacks->VideoOutputDim.X * Scale) & ~1),
+			FMath::Max(2, FMath::FloorToInt(Callbacks->VideoOutputDim.Y * Scale) & ~1)
+		);
+
+		UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Callbacks %llx: Scaling video from %ix%i to %ix%i"),
+			Opaque,
+			Callbacks->VideoOutputDim.X,
+			Callbacks->VideoOutputDim.Y,
+			ScaledDim.X,
+			ScaledDim.Y
+		);
+
+		// VLC scales the decoded pictures to the requested buffer size
+		Callbacks->VideoOutputDim = ScaledDim;
+		*Width = ScaledDim.X;
+		*Height = ScaledDim.Y;
+	}
+
 	// determine decoder & sample formats
 	Callbacks->VideoBufferDim = FIntPoint(*Width, *Height);
 
+	Callbacks->VideoConverterEnabled = false;
+	Callbacks->VideoPlanes.Reset();
+
 	if (FCStringAnsi::Stricmp(Chroma, "AYUV") == 0)
 	{
 		Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharAYUV;
-		Callbacks->VideoBufferStride = *Width * 4;
+		Callbacks->VideoPlanes.SetSinglePlane(*Width * 4, *Height);
 	}
 	else if (FCStringAnsi::Stricmp(Chroma, "RV32") == 0)
 	{
 		Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharBGRA;
-		Callbacks->VideoBufferStride = *Width * 4;
+		Callbacks->VideoPlanes.SetSinglePlane(*Width * 4, *Height);
 	}
 	else if ((FCStringAnsi::Stricmp(Chroma, "UYVY") == 0) ||
 		(FCStringAnsi::Stricmp(Chroma, "Y422") == 0) ||
@@ -393,37 +910,78 @@ unsigned FVlcMediaPlayerCallbacks::StaticVideoSetupCallback(void** Opaque, char*
 		(FCStringAnsi::Stricmp(Chroma, "HDYC") == 0))
 	{
 		Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharUYVY;
-		Callbacks->VideoBufferStride = *Width * 2;
+		Callbacks->VideoPlanes.SetSinglePlane(*Width * 2, *Height);
 	}
 	else if ((FCStringAnsi::Stricmp(Chroma, "YUY2") == 0) ||
 		(FCStringAnsi::Stricmp(Chroma, "V422") == 0) ||
 		(FCStringAnsi::Stricmp(Chroma, "YUYV") == 0))
 	{
 		Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharYUY2;
-		Callbacks->VideoBufferStride = *Width * 2;
+		Callbacks->VideoPlanes.SetSinglePlane(*Width * 2, *Height);
 	}
 	else if (FCStringAnsi::Stricmp(Chroma, "YVYU") == 0)
 	{
 		Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharYVYU;
-		Callbacks->VideoBufferStride = *Width * 2;
+		Callbacks->VideoPlanes.SetSinglePlane(*Width * 2, *Height);
 	}
 	else
 	{
 		// reconfigure output for natively supported format
 		const vlc_chroma_description_t* ChromaDescr = vlc_fourcc_GetChromaDescription(*(vlc_fourcc_t*)Chroma);
 
-		if (ChromaDescr->plane_count == 0)
+		if ((ChromaDescr == nullptr) || (ChromaDescr->plane_count == 0))
 		{
 			return 0;
 		}
 
-		if (ChromaDescr->plane_count > 1)
+		if ((Callbacks->VideoOutput == EVlcMediaPlayerVideoOutput::NativePlanar) && VlcMediaPlayerCallbacks::IsPlanar420(*ChromaDescr))
+		{
+			// keep 4:2:0 layout; I420 & YV12 only need their chroma planes interleaved
+			FMemory::Memcpy(Chroma, "NV12", 4);
+
+			const uint32 Pitch = Align(*Width, 32);
+			const uint32 LumaLines = Align(*Height, 16);
+
+			Callbacks->VideoPlanes.NumPlanes = 2;
+			Callbacks->VideoPlanes.Pitches[0] = Pitch;
+			Callbacks->VideoPlanes.Lines[0] = LumaLines;
+			Callbacks->VideoPlanes.Pitches[1] = Pitch;
+			Callbacks->VideoPlanes.Lines[1] = LumaLines / 2;
+
+			Callbacks->VideoBufferDim = FIntPoint(Pitch, LumaLines * 3 / 2);
+			Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharNV12;
+		}
+		else if ((Callbacks->VideoOutput == EVlcMediaPlayerVideoOutput::Bgra) && VlcMediaPlayerCallbacks::IsPlanar420(*ChromaDescr))
+		{
+			// keep 4:2:0 layout; frames are converted to BGRA in the unlock callback
+			const bool FullRange = (FCStringAnsi::Stricmp(Chroma, "J420") == 0);
+			FMemory::Memcpy(Chroma, FullRange ? "J420" : "I420", 4);
+
+			const uint32 Pitch = Align(*Width, 32);
+			const uint32 LumaLines = Align(*Height, 16);
+
+			Callbacks->VideoPlanes.NumPlanes = 3;
+			Callbacks->VideoPlanes.Pitches[0] = Pitch;
+			Callbacks->VideoPlanes.Lines[0] = LumaLines;
+
+			for (uint32 Plane = 1; Plane < 3; ++Plane)
+			{
+				Callbacks->VideoPlanes.Pitches[Plane] = Pitch / 2;
+				Callbacks->VideoPlanes.Lines[Plane] = LumaLines / 2;
+			}
+
+			// VLC 3 does not expose the color space, so assume BT.709 for HD video
+			Callbacks->VideoConverter.Configure((*Height >= 720) ? EVlcMediaPlayerColorMatrix::Bt709 : EVlcMediaPlayerColorMatrix::Bt601, FullRange);
+			Callbacks->VideoConverterEnabled = true;
+			Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharBGRA;
+		}
+		else if (ChromaDescr->plane_count > 1)
 		{
 			FMemory::Memcpy(Chroma, "YUY2", 4);
 
 			Callbacks->VideoBufferDim = FIntPoint(Align(Callbacks->VideoOutputDim.X, 16) / 2, Align(Callbacks->VideoOutputDim.Y, 16));
 			Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharYUY2;
-			Callbacks->VideoBufferStride = Callbacks->VideoBufferDim.X * 4;
+			Callbacks->VideoPlanes.SetSinglePlane(Callbacks->VideoBufferDim.X * 4, Callbacks->VideoBufferDim.Y);
 			*Height = Callbacks->VideoBufferDim.Y;
 		}
 		else
@@ -432,18 +990,44 @@ unsigned FVlcMediaPlayerCallbacks::StaticVideoSetupCallback(void** Opaque, char*
 
 			Callbacks->VideoBufferDim = Callbacks->VideoOutputDim;
 			Callbacks->VideoSampleFormat = EMediaTextureSampleFormat::CharBGRA;
-			Callbacks->VideoBufferStride = Callbacks->VideoBufferDim.X * 4;
+			Callbacks->VideoPlanes.SetSinglePlane(Callbacks->VideoBufferDim.X * 4, Callbacks->VideoBufferDim.Y);
 		}
 	}
 
-	// get other video properties
-	//Callbacks->VideoFrameDuration = FTimespan::FromSeconds(1.0 / FVlc::MediaPlayerGetFps(Callbacks->Player));
+	if (Callbacks->VideoConverterEnabled)
+	{
+		Callbacks->VideoSamplePlanes.SetSinglePlane(Callbacks->VideoBufferDim.X * 4, Callbacks->VideoBufferDim.Y);
+	}
+	else
+	{
+		Callbacks->VideoSamplePlanes = Callbacks->VideoPlanes;
+	}
+
+	// get other video properties; the measured frame intervals refine the nominal frame rate
+	const float FrameRate = Callbacks->VideoNominalFrameRate.load();
+
+	Callbacks->VideoFrameDuration = FTimespan::FromSeconds(1.0 / ((FrameRate > 0.0f) ? FrameRate : VlcMediaPlayerCallbacks::DefaultFrameRate));
+	Callbacks->VideoFrameRate = FrameRate;
+	Callbacks->VideoPreviousDisplayClock = -1;
+	Callbacks->VideoPreviousDisplayTime = FTimespan::MinValue();
+
+	// allocate buffer for frames that won't be displayed or will be converted
+	const SIZE_T BufferSize = Callbacks->VideoPlanes.GetBufferSize();
+
+	if (BufferSize > Callbacks->VideoDiscardBufferSize)
+	{
+		Callbacks->VideoDiscardBuffer = FMemory::Realloc(Callbacks->VideoDiscardBuffer, BufferSize, 32);
+		Callbacks->VideoDiscardBufferSize = BufferSize;
+	}
 
-	Callbacks->VideoFrameDuration = FTimespan::FromMilliseconds(1);
+	Callbacks->VideoFramesSinceSetup = 0;
 
 	// initialize decoder
-	Lines[0] = Callbacks->VideoBufferDim.Y;
-	Pitches[0] = Callbacks->VideoBufferStride;
+	for (uint32 Plane = 0; Plane < Callbacks->VideoPlanes.NumPlanes; ++Plane)
+	{
+		Lines[Plane] = Callbacks->VideoPlanes.Lines[Plane];
+		Pitches[Plane] = Callbacks->VideoPlanes.Pitches[Plane];
+	}
 
 	return 1;
 }
@@ -451,14 +1035,35 @@ unsigned FVlcMediaPlayerCallbacks::StaticVideoSetupCallback(void** Opaque, char*
 
 void FVlcMediaPlayerCallbacks::StaticVideoUnlockCallback(void* Opaque, void* Picture, void* const* Planes)
 {
-	if ((Opaque != nullptr) && (Picture != nullptr))
+	auto Callbacks = (FVlcMediaPlayerCallbacks*)Opaque;
+	auto VideoSample = (FVlcMediaPlayerTextureSample*)Picture;
+
+	if ((Callbacks == nullptr) || (VideoSample == nullptr))
 	{
-		UE_LOG(LogVlcMediaPlayer, VeryVerbose, TEXT("Callbacks %llx: StaticVideoUnlockCallback"), Opaque);
+		return; // discard buffer is reused for the next skipped frame
 	}
 
-	// discard temporary buffer for VLC crash workaround
-	if ((Picture == nullptr) && (Planes != nullptr) && (Planes[0] != nullptr))
+	UE_LOG(LogVlcMediaPlayer, VeryVerbose, TEXT("Callbacks %llx: StaticVideoUnlockCallback"), Opaque);
+
+	// convert staged frame
+	if (Callbacks->VideoConverterEnabled)
 	{
-		FMemory::Free(Planes[0]);
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+
+		Callbacks->VideoConverter.Convert(
+			(const uint8* const*)Planes,
+			Callbacks->VideoPlanes.Pitches,
+			(uint8*)VideoSample->GetMutableBuffer(),
+			VideoSample->GetStride(),
+			Callbacks->VideoBufferDim
+		);
+
+		Callbacks->VideoConversionCycles += FPlatformTime::Cycles64() - StartCycles;
+		Callbacks->VideoConversionPixels += (int64)Callbacks->VideoBufferDim.X * Callbacks->VideoBufferDim.Y;
 	}
+
+	// VLC unlocks a picture before displaying it, and displays it before locking the next
+	// one, so the sample can't be reused before it is queued; queued samples stay in use
+	// while they are referenced
+	Callbacks->VideoSamplePool->Release(VideoSample);
 }
@@ -3,13 +3,20 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
 #include "IMediaAudioSample.h"
 #include "IMediaTextureSample.h"
+#include "VlcMediaPlayerSettings.h"
 
+#include "VlcMediaPlayerAudioRing.h"
+#include "VlcMediaPlayerColorConverter.h"
+#include "VlcMediaPlayerTextureSample.h"
+#include "VlcMediaPlayerVideoQueue.h"
 #include "VlcWrapper.h"
 
-class FMediaSamples;
-class FVlcMediaAudioSamplePool;
+#include <atomic>
+
+class FVlcMediaPlayerSamples;
 class FVlcMediaTextureSamplePool;
 class IMediaOptions;
 class IMediaAudioSink;
@@ -27,6 +34,9 @@ class FVlcMediaPlayerCallbacks
 {
 public:
 
+	/** Maximum number of audio channels that are passed to the engine. */
+	static const uint32 MaxAudioChannels = 8;
+
 	/** Default constructor. */
 	FVlcMediaPlayerCallbacks();
 
@@ -35,6 +45,88 @@ public:
 
 public:
 
+	/** Video settings of a media, from the plug-in settings and media options. */
+	struct FVideoSettings
+	{
+		/** Maximum video output dimensions (zero = unlimited). */
+		FIntPoint MaxOutputDim = FIntPoint::ZeroValue;
+
+		/** Video output mode. */
+		EVlcMediaPlayerVideoOutput Output = EVlcMediaPlayerVideoOutput::Packed;
+
+		/** Maximum number of decoded frames waiting to be consumed. */
+		int32 QueueDepth = 1;
+
+		/** What to do with new frames when the queue is full. */
+		EVlcMediaPlayerQueuePolicy QueuePolicy = EVlcMediaPlayerQueuePolicy::DropOldest;
+	};
+
+	/**
+	 * Get the video settings for a media.
+	 *
+	 * @param Options Optional media options that override the plug-in settings.
+	 * @return The video settings.
+	 */
+	static FVideoSettings GetVideoSettings(const IMediaOptions* Options);
+
+public:
+
+	/**
+	 * Configure the handler for the next media to be played.
+	 *
+	 * The handler must not be registered with a player that may set up its video output.
+	 *
+	 * @param Settings The video settings to use.
+	 * @see ConfigureQueue
+	 */
+	void Configure(const FVideoSettings& Settings);
+
+	/**
+	 * Configure the handler like another handler, i.e. for media played in sequence.
+	 *
+	 * @param Other The handler whose configuration to copy.
+	 */
+	void Configure(const FVlcMediaPlayerCallbacks& Other);
+
+	/**
+	 * Configure the video sample queue for the next media to be played.
+	 *
+	 * Unlike Configure, this method may be called while the handler is registered with a
+	 * player, as long as the player's input is stopped.
+	 *
+	 * @param Settings The video settings whose queue settings to use.
+	 */
+	void ConfigureQueue(const FVideoSettings& Settings);
+
+	/**
+	 * Discard all pending and queued media samples.
+	 *
+	 * @see GetSamples
+	 */
+	void FlushSamples();
+
+	/**
+	 * Hand pending video samples to the output media samples.
+	 *
+	 * This method must be called once per game tick. It moves no more samples than the
+	 * configured queue depth allows, so that the output queue does not grow without bound.
+	 *
+	 * @return Number of samples that were forwarded.
+	 */
+	int32 ForwardVideoSamples();
+
+	/**
+	 * Check whether the video output was set up with the specified settings.
+	 *
+	 * A player's video output is kept when its media is switched, and is not set up again
+	 * if the new media has the same format. Players can only be reused for media whose
+	 * output settings match.
+	 *
+	 * @param Settings The video settings to check.
+	 * @return true if the settings that affect the video output match, false otherwise.
+	 */
+	bool HasVideoOutput(const FVideoSettings& Settings) const;
+
 	/**
 	 * Get the output media samples.
 	 *
@@ -42,6 +134,24 @@ public:
 	 */
 	IMediaSamples& GetSamples();
 
+	/**
+	 * Get playback statistics collected by the callbacks.
+	 *
+	 * @return Statistics string.
+	 */
+	FString GetStats() const;
+
+	/**
+	 * Get the frame rate of the video that is currently being played.
+	 *
+	 * The frame rate is initialized from the stream's nominal frame rate and then
+	 * follows the measured intervals between displayed frames, so that it tracks
+	 * variable frame rate content.
+	 *
+	 * @return Frame rate (in frames per second), or zero if not known yet.
+	 */
+	float GetVideoFrameRate() const;
+
 	/**
 	 * Initialize the handler for the specified media player.
 	 *
@@ -50,14 +160,40 @@ public:
 	void Initialize(libvlc_media_player_t& InPlayer);
 
 	/**
-	 * Set the player's current time.
+	 * Measure the seam at which a repeating input wrapped around to the beginning of the media.
+	 *
+	 * This method may be called on any thread. The seam is evaluated when the next frame is displayed.
+	 */
+	void MarkLoopSeam();
+
+	/**
+	 * Prepare the handler for the next media played by the same player.
+	 *
+	 * Unlike Initialize, this keeps the callbacks registered and the sample pools allocated.
+	 */
+	void Restart();
+
+	/**
+	 * Set the player's current time and rate.
+	 *
+	 * VLC's presentation timestamps are converted into the player's clock relative to
+	 * the time and rate of the most recent call.
 	 *
 	 * @param Time The player's play time.
+	 * @param Rate The player's play rate.
 	 */
-	void SetCurrentTime(FTimespan Time)
-	{
-		CurrentTime = Time;
-	}
+	void SetCurrentTime(FTimespan Time, float Rate);
+
+	/**
+	 * Set the nominal frame rate of the media's video.
+	 *
+	 * The rate is read from the parsed media on the game thread, because VLC's player
+	 * functions must not be called from within the video callbacks. It seeds the frame
+	 * duration when the video output is set up next.
+	 *
+	 * @param FrameRate The frame rate (in frames per second), or zero if unknown.
+	 */
+	void SetNominalVideoFrameRate(float FrameRate);
 
 	/** Shut down the callback handler. */
 	void Shutdown();
@@ -102,48 +238,196 @@ private:
 
 private:
 
+	/**
+	 * Hand the discard buffer to VLC for a frame that will not be displayed.
+	 *
+	 * @param Planes VLC's pixel plane pointers to initialize.
+	 * @return The picture handle to return from the lock callback.
+	 */
+	void* LockDiscardBuffer(void** Planes);
+
+	/**
+	 * Freeze the conversion of presentation timestamps at the specified timestamp.
+	 *
+	 * Timestamps don't advance the time until VLC resumes the audio output, even if the
+	 * player sets its time and rate in the meantime.
+	 *
+	 * @param Timestamp The timestamp at which audio output was paused (in libvlc_clock microseconds).
+	 * @see ResumeTime
+	 */
+	void PauseTime(int64 Timestamp);
+
+	/**
+	 * Continue the conversion of presentation timestamps from the specified timestamp.
+	 *
+	 * @param Timestamp The timestamp at which audio output was resumed (in libvlc_clock microseconds).
+	 * @see PauseTime
+	 */
+	void ResumeTime(int64 Timestamp);
+
+	/**
+	 * Convert a VLC presentation timestamp into the player's clock.
+	 *
+	 * @param Timestamp The presentation timestamp (in libvlc_clock microseconds).
+	 * @return The corresponding play time.
+	 */
+	FTimespan TimestampToTime(int64 Timestamp) const;
+
+	/** Record a heap allocation made by the video callbacks. */
+	void TrackVideoAllocation();
+
+	/**
+	 * Record the interval since the previously displayed frame, and evaluate a pending loop seam.
+	 *
+	 * @param Timestamp The time at which the frame is displayed (in libvlc_clock microseconds).
+	 * @see MarkLoopSeam
+	 */
+	void UpdateLoopSeam(int64 Timestamp);
+
+	/**
+	 * Update the video frame duration with the interval since the previously displayed frame.
+	 *
+	 * @param Time The play time of the frame being displayed.
+	 */
+	void UpdateVideoFrameDuration(FTimespan Time);
+
+private:
+
+	/** Number of recent display intervals that are searched for a loop seam. */
+	static const int32 NumRecentIntervals = 8;
+
 	/** Current number of channels in audio samples( accessed by VLC thread only). */
 	uint32 AudioChannels;
 
+	/** Whether a pending audio drain should stop waiting for the queued samples to be consumed. */
+	std::atomic<bool> AudioDrainAborted;
+
+	/** Whether VLC paused the audio output (guarded by CurrentTimeCriticalSection). */
+	bool AudioPaused;
+
+	/** Ring buffer that holds the audio frames (accessed by VLC thread only). */
+	FVlcMediaPlayerAudioRing AudioRing;
+
 	/** Current audio sample format (accessed by VLC thread only). */
 	EMediaAudioSampleFormat AudioSampleFormat;
 
-	/** Audio sample object pool. */
-	FVlcMediaAudioSamplePool* AudioSamplePool;
-
 	/** Current audio sample rate (accessed by VLC thread only). */
 	uint32 AudioSampleRate;
 
 	/** Size of a single audio sample (in bytes). */
 	SIZE_T AudioSampleSize;
 
+	/** Critical section for synchronizing access to the current time. */
+	mutable FCriticalSection CurrentTimeCriticalSection;
+
+	/** The rate at which presentation timestamps advance the current time (zero while audio output is paused). */
+	float CurrentRate;
+
 	/** The player's current time. */
 	FTimespan CurrentTime;
 
+	/** The libvlc_clock time at which the current time was set (in microseconds). */
+	int64 CurrentTimeClock;
+
 	/** The VLC media player object. */
 	libvlc_media_player_t* Player;
 
+	/** The most recent non-zero play rate, which is restored when audio output resumes. */
+	float ResumeRate;
+
 	/** The output media samples. */
-	FMediaSamples* Samples;
+	FVlcMediaPlayerSamples* Samples;
+
+	/** Number of heap allocations made by the video callbacks. */
+	std::atomic<int32> VideoAllocations;
 
 	/** Current video buffer dimensions (accessed by VLC thread only; may be larger than VideoOutputDim). */
 	FIntPoint VideoBufferDim;
 
-	/** Number of bytes per row of video pixels. */
-	uint32 VideoBufferStride;
+	/** Number of CPU cycles spent converting video frames. */
+	std::atomic<int64> VideoConversionCycles;
 
-	/** Current duration of video frames. */
+	/** Number of video pixels converted. */
+	std::atomic<int64> VideoConversionPixels;
+
+	/** Converts 4:2:0 video frames to BGRA (accessed by VLC thread only). */
+	FVlcMediaPlayerColorConverter VideoConverter;
+
+	/** Whether video frames are converted by the plug-in (accessed by VLC thread only). */
+	bool VideoConverterEnabled;
+
+	/** Buffer that receives frames which are decoded but not displayed, or which are converted before display (accessed by VLC thread only). */
+	void* VideoDiscardBuffer;
+
+	/** Allocated size of the discard buffer (in bytes). */
+	SIZE_T VideoDiscardBufferSize;
+
+	/** Current duration of video frames (accessed by VLC thread only). */
 	FTimespan VideoFrameDuration;
 
+	/** Current frame rate of the video (in frames per second; zero if unknown). */
+	std::atomic<float> VideoFrameRate;
+
+	/** Number of frames displayed since the video format was set up (accessed by VLC thread only). */
+	uint32 VideoFramesSinceSetup;
+
+	/** Duration of the most recent loop seam beyond the regular frame interval (in microseconds). */
+	std::atomic<int64> VideoLastLoopSeam;
+
+	/** Whether the next displayed frame completes a loop seam. */
+	std::atomic<bool> VideoLoopSeamPending;
+
+	/** Number of loop seams that were measured. */
+	std::atomic<int32> VideoLoopSeams;
+
+	/** Longest loop seam beyond the regular frame interval (in microseconds). */
+	std::atomic<int64> VideoMaxLoopSeam;
+
+	/** Maximum video output dimensions (zero = unlimited; overrides the plug-in settings). */
+	FIntPoint VideoMaxOutputDim;
+
+	/** Nominal frame rate of the media's video (in frames per second; zero if unknown). */
+	std::atomic<float> VideoNominalFrameRate;
+
+	/** Number of frames dropped because all video samples were in use. */
+	std::atomic<int32> VideoPoolDrops;
+
+	/** Current video output mode (overrides the plug-in settings). */
+	EVlcMediaPlayerVideoOutput VideoOutput;
+
 	/** Current video output dimensions (accessed by VLC thread only). */
 	FIntPoint VideoOutputDim;
 
-	/** Play time of the previous frame. */
-	FTimespan VideoPreviousTime;
+	/** Time at which the previous video frame was displayed (in libvlc_clock microseconds, or -1; accessed by VLC thread only). */
+	int64 VideoPreviousDisplayClock;
+
+	/** Play time of the previously displayed video frame (accessed by VLC thread only). */
+	FTimespan VideoPreviousDisplayTime;
+
+	/** Current layout of the pixel planes written by VLC (accessed by VLC thread only). */
+	FVlcMediaPlayerPlaneLayout VideoPlanes;
 
 	/** Current video sample format (accessed by VLC thread only). */
 	EMediaTextureSampleFormat VideoSampleFormat;
 
+	/** Current layout of the video samples' pixel planes (differs from VideoPlanes if frames are converted; accessed by VLC thread only). */
+	FVlcMediaPlayerPlaneLayout VideoSamplePlanes;
+
+	/** Bounded queue of displayed video samples that are waiting to be forwarded. */
+	FVlcMediaPlayerVideoQueue VideoQueue;
+
+	/** Intervals between the most recently displayed frames (in microseconds; accessed by VLC thread only). */
+	int64 VideoRecentIntervals[NumRecentIntervals];
+
+	/** Index at which the next display interval is recorded (accessed by VLC thread only). */
+	uint32 VideoRecentIntervalIndex;
+
 	/** Video sample object pool. */
 	FVlcMediaTextureSamplePool* VideoSamplePool;
+
+	/** Maximum number of samples in the video sample pool. */
+	std::atomic<int32> VideoSamplePoolLimit;
+
+	/** Number of heap allocations made by the video callbacks after reaching steady state. */
+	std::atomic<int32> VideoSteadyStateAllocations;
 };
\ No newline at end of file
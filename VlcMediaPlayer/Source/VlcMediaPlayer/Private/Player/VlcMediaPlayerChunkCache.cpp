@@ -0,0 +1,268 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#include "VlcMediaPlayerChunkCache.h"
+#include "VlcMediaPlayerPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/Class.h"
+
+
+/* FVlcMediaPlayerChunkCache::FChunk structors
+ *****************************************************************************/
+
+FVlcMediaPlayerChunkCache::FChunk::FChunk()
+	: Failed(false)
+	, LastUse(0)
+	, Loaded(false)
+	, LoadedEvent(FPlatformProcess::GetSynchEventFromPool(true))
+{ }
+
+
+FVlcMediaPlayerChunkCache::FChunk::~FChunk()
+{
+	FPlatformProcess::ReturnSynchEventToPool(LoadedEvent);
+}
+
+
+/* FVlcMediaPlayerChunkCache structors
+ *****************************************************************************/
+
+FVlcMediaPlayerChunkCache::FVlcMediaPlayerChunkCache()
+	: BytesLoaded(0)
+	, Hits(0)
+	, Misses(0)
+	, NextSourceId(0)
+	, NumEvictions(0)
+	, SharedLoads(0)
+	, StripeCapacity(0)
+{
+	const int64 Capacity = (int64)FMath::Max(0, GetDefault<UVlcMediaPlayerSettings>()->ChunkCacheSize) * 1024 * 1024;
+
+	if (Capacity > 0)
+	{
+		StripeCapacity = FMath::Max(Capacity / NumStripes, ChunkSize);
+	}
+}
+
+
+/* FVlcMediaPlayerChunkCache interface
+ *****************************************************************************/
+
+FVlcMediaPlayerChunkCache& FVlcMediaPlayerChunkCache::Get()
+{
+	static FVlcMediaPlayerChunkCache ChunkCache;
+	return ChunkCache;
+}
+
+
+TSharedPtr<FVlcMediaPlayerChunkCache::FChunk, ESPMode::ThreadSafe> FVlcMediaPlayerChunkCache::GetChunk(const FSource& Source, int64 ChunkIndex, TFunctionRef<bool(TArray<uint8>&)> Load)
+{
+	const FChunkKey Key{ ChunkIndex, Source.Id };
+	FStripe& Stripe = Stripes[GetTypeHash(Key) % NumStripes];
+
+	TSharedPtr<FChunk, ESPMode::ThreadSafe> Chunk;
+	bool Loading = false;
+	{
+		FScopeLock Lock(&Stripe.CriticalSection);
+
+		if (const TSharedPtr<FChunk, ESPMode::ThreadSafe>* Found = Stripe.Chunks.Find(Key))
+		{
+			Chunk = *Found;
+		}
+		else
+		{
+			Chunk = MakeShared<FChunk, ESPMode::ThreadSafe>();
+			Stripe.Chunks.Add(Key, Chunk);
+			Loading = true;
+		}
+
+		Chunk->LastUse = ++Stripe.UseCount;
+	}
+
+	if (!Loading)
+	{
+		// another reader may still be loading the chunk
+		if (Chunk->Loaded)
+		{
+			++Hits;
+		}
+		else
+		{
+			++SharedLoads;
+			Chunk->LoadedEvent->Wait();
+		}
+
+		return Chunk->Failed ? nullptr : Chunk;
+	}
+
+	// load the chunk outside of the lock
+	++Misses;
+
+	const bool Succeeded = Load(Chunk->Data);
+	{
+		FScopeLock Lock(&Stripe.CriticalSection);
+
+		if (Succeeded)
+		{
+			Chunk->Loaded = true;
+			BytesLoaded += Chunk->Data.Num();
+
+			// the chunk isn't accounted for if its source was released while it was loading
+			if (Stripe.Chunks.FindRef(Key) == Chunk)
+			{
+				Stripe.Bytes += Chunk->Data.Num();
+				Evict(Stripe);
+			}
+		}
+		else
+		{
+			Chunk->Failed = true;
+
+			if (Stripe.Chunks.FindRef(Key) == Chunk)
+			{
+				Stripe.Chunks.Remove(Key); // so that the next read retries
+			}
+		}
+	}
+
+	Chunk->LoadedEvent->Trigger();
+
+	return Succeeded ? Chunk : nullptr;
+}
+
+
+FString FVlcMediaPlayerChunkCache::GetStats() const
+{
+	int64 Bytes = 0;
+	int32 NumChunks = 0;
+
+	for (const FStripe& Stripe : Stripes)
+	{
+		FScopeLock Lock(&Stripe.CriticalSection);
+
+		Bytes += Stripe.Bytes;
+		NumChunks += Stripe.Chunks.Num();
+	}
+
+	FString StatsString;
+	{
+		StatsString += TEXT("Chunk Cache\n");
+		StatsString += FString::Printf(TEXT("    Capacity: %.1f MB\n"), StripeCapacity * NumStripes / (1024.0 * 1024.0));
+		StatsString += FString::Printf(TEXT("    Used: %.1f MB (%i chunks)\n"), Bytes / (1024.0 * 1024.0), NumChunks);
+		StatsString += FString::Printf(TEXT("    Evictions: %i\n"), NumEvictions.load());
+		StatsString += FString::Printf(TEXT("    Hits: %i\n"), Hits.load());
+		StatsString += FString::Printf(TEXT("    Shared Loads: %i\n"), SharedLoads.load());
+		StatsString += FString::Printf(TEXT("    Misses: %i\n"), Misses.load());
+		StatsString += FString::Printf(TEXT("    Loaded: %.1f MB\n"), BytesLoaded.load() / (1024.0 * 1024.0));
+
+		FScopeLock Lock(&SourcesCriticalSection);
+		StatsString += FString::Printf(TEXT("    Sources: %i\n"), Sources.Num());
+		StatsString += TEXT("\n");
+	}
+
+	return StatsString;
+}
+
+
+FVlcMediaPlayerChunkCache::FSource& FVlcMediaPlayerChunkCache::RegisterSource(const FString& Url, int64 Size)
+{
+	FScopeLock Lock(&SourcesCriticalSection);
+
+	for (const TUniquePtr<FSource>& Source : Sources)
+	{
+		if ((Source->Size == Size) && (Source->Url == Url))
+		{
+			++Source->NumRegistrations;
+			return *Source;
+		}
+	}
+
+	FSource* Source = new FSource;
+	{
+		Source->Id = NextSourceId++;
+		Source->NumRegistrations = 1;
+		Source->Size = Size;
+		Source->Url = Url;
+	}
+
+	Sources.Emplace(Source);
+
+	return *Source;
+}
+
+
+void FVlcMediaPlayerChunkCache::ReleaseSource(FSource& Source)
+{
+	FScopeLock Lock(&SourcesCriticalSection);
+
+	check(Source.NumRegistrations > 0);
+
+	if (--Source.NumRegistrations > 0)
+	{
+		return;
+	}
+
+	// readers that still hold a chunk keep its data alive
+	for (FStripe& Stripe : Stripes)
+	{
+		FScopeLock StripeLock(&Stripe.CriticalSection);
+
+		for (auto It = Stripe.Chunks.CreateIterator(); It; ++It)
+		{
+			if (It.Key().SourceId == Source.Id)
+			{
+				if (It.Value()->Loaded)
+				{
+					Stripe.Bytes -= It.Value()->Data.Num();
+				}
+
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	const int32 SourceId = Source.Id;
+
+	Sources.RemoveAll([SourceId](const TUniquePtr<FSource>& Registered)
+	{
+		return (Registered->Id == SourceId);
+	});
+}
+
+
+/* FVlcMediaPlayerChunkCache implementation
+ *****************************************************************************/
+
+void FVlcMediaPlayerChunkCache::Evict(FStripe& Stripe)
+{
+	while (Stripe.Bytes > StripeCapacity)
+	{
+		const FChunkKey* OldestKey = nullptr;
+		uint64 OldestUse = MAX_uint64;
+
+		// chunks that are still loading have no data to evict yet
+		for (const TPair<FChunkKey, TSharedPtr<FChunk, ESPMode::ThreadSafe>>& Pair : Stripe.Chunks)
+		{
+			if (Pair.Value->Loaded && (Pair.Value->LastUse < OldestUse))
+			{
+				OldestKey = &Pair.Key;
+				OldestUse = Pair.Value->LastUse;
+			}
+		}
+
+		if (OldestKey == nullptr)
+		{
+			break;
+		}
+
+		// readers that hold the chunk keep its data alive
+		const FChunkKey Key = *OldestKey;
+
+		Stripe.Bytes -= Stripe.Chunks[Key]->Data.Num();
+		Stripe.Chunks.Remove(Key);
+
+		++NumEvictions;
+	}
+}
@@ -0,0 +1,219 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/Function.h"
+#include "Templates/SharedPointer.h"
+#include "Templates/UniquePtr.h"
+
+#include <atomic>
+
+class FEvent;
+
+
+/**
+ * Caches chunks of archive-backed media for all players in the process.
+ *
+ * Chunks are keyed by the media URL and their offset. If several players read the same
+ * chunk at the same time, only the first one loads it from its archive, and the others
+ * wait for the result. The cache is split into stripes that are locked independently,
+ * and each stripe evicts its least recently used chunks when it exceeds its share of
+ * the configured capacity.
+ */
+class FVlcMediaPlayerChunkCache
+{
+public:
+
+	/** Size of the cached chunks (in bytes). */
+	static const int64 ChunkSize = 1024 * 1024;
+
+	/** Number of independently locked stripes. */
+	static const int32 NumStripes = 16;
+
+	/** A cached chunk of media data. */
+	struct FChunk
+	{
+		/** The chunk's data (immutable once loaded). */
+		TArray<uint8> Data;
+
+		/** Whether loading the chunk failed. */
+		std::atomic<bool> Failed;
+
+		/** Stripe use count at the most recent access (guarded by the stripe's lock). */
+		uint64 LastUse;
+
+		/** Whether the chunk was loaded. */
+		std::atomic<bool> Loaded;
+
+		/** Triggered when the chunk was loaded, or loading failed. */
+		FEvent* LoadedEvent;
+
+		/** Default constructor. */
+		FChunk();
+
+		/** Destructor. */
+		~FChunk();
+	};
+
+	/** A media source registered with the cache. */
+	struct FSource
+	{
+		/** Unique identifier of the source. */
+		int32 Id;
+
+		/** Number of registrations that weren't released yet (guarded by the sources lock). */
+		int32 NumRegistrations;
+
+		/** Size of the media (in bytes). */
+		int64 Size;
+
+		/** The media URL. */
+		FString Url;
+	};
+
+	/**
+	 * Get the cache singleton.
+	 *
+	 * @return The cache.
+	 */
+	static FVlcMediaPlayerChunkCache& Get();
+
+public:
+
+	/**
+	 * Get a chunk of media data, loading it if it isn't cached.
+	 *
+	 * @param Source The source that the chunk belongs to.
+	 * @param ChunkIndex Index of the chunk in the media.
+	 * @param Load Function that loads the chunk's data, returning false on failure.
+	 * @return The chunk, or nullptr if it couldn't be loaded.
+	 */
+	TSharedPtr<FChunk, ESPMode::ThreadSafe> GetChunk(const FSource& Source, int64 ChunkIndex, TFunctionRef<bool(TArray<uint8>&)> Load);
+
+	/**
+	 * Get cache statistics.
+	 *
+	 * @return Statistics string.
+	 */
+	FString GetStats() const;
+
+	/**
+	 * Check whether the cache is enabled.
+	 *
+	 * @return true if enabled, false otherwise.
+	 */
+	bool IsEnabled() const
+	{
+		return (StripeCapacity > 0);
+	}
+
+	/**
+	 * Register a media source with the cache.
+	 *
+	 * Sources with the same URL and size share their chunks. Each registration must be
+	 * released when the archive that reads the source is closed.
+	 *
+	 * @param Url The media URL.
+	 * @param Size The size of the media (in bytes).
+	 * @return The source.
+	 * @see ReleaseSource
+	 */
+	FSource& RegisterSource(const FString& Url, int64 Size);
+
+	/**
+	 * Release a registration of a media source.
+	 *
+	 * When the last registration is released, the source's chunks are dropped from the
+	 * cache, and the source must no longer be used.
+	 *
+	 * @param Source The source to release.
+	 * @see RegisterSource
+	 */
+	void ReleaseSource(FSource& Source);
+
+protected:
+
+	/** Hidden constructor (use Get). */
+	FVlcMediaPlayerChunkCache();
+
+private:
+
+	/** Key of a cached chunk. */
+	struct FChunkKey
+	{
+		/** Index of the chunk in the media. */
+		int64 ChunkIndex;
+
+		/** Identifier of the source that the chunk belongs to. */
+		int32 SourceId;
+
+		bool operator==(const FChunkKey& Other) const
+		{
+			return (ChunkIndex == Other.ChunkIndex) && (SourceId == Other.SourceId);
+		}
+
+		friend uint32 GetTypeHash(const FChunkKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.SourceId), GetTypeHash(Key.ChunkIndex));
+		}
+	};
+
+	/** An independently locked part of the cache. */
+	struct FStripe
+	{
+		/** Number of bytes in loaded chunks. */
+		int64 Bytes = 0;
+
+		/** The cached chunks, including chunks that are still loading. */
+		TMap<FChunkKey, TSharedPtr<FChunk, ESPMode::ThreadSafe>> Chunks;
+
+		/** Critical section for synchronizing access to the stripe. */
+		mutable FCriticalSection CriticalSection;
+
+		/** Incremented on each access, for ordering chunks by use. */
+		uint64 UseCount = 0;
+	};
+
+	/**
+	 * Evict least recently used chunks until the stripe fits its capacity.
+	 *
+	 * The stripe's critical section must be locked.
+	 *
+	 * @param Stripe The stripe to evict chunks from.
+	 */
+	void Evict(FStripe& Stripe);
+
+private:
+
+	/** Number of bytes loaded from the sources' archives. */
+	std::atomic<int64> BytesLoaded;
+
+	/** Number of chunk reads that were served from the cache. */
+	std::atomic<int32> Hits;
+
+	/** Number of chunks that had to be loaded. */
+	std::atomic<int32> Misses;
+
+	/** Identifier of the next registered source (guarded by the sources lock). */
+	int32 NextSourceId;
+
+	/** Number of chunks that were evicted. */
+	std::atomic<int32> NumEvictions;
+
+	/** Number of chunk reads that waited for another reader to load the chunk. */
+	std::atomic<int32> SharedLoads;
+
+	/** The registered media sources. */
+	TArray<TUniquePtr<FSource>> Sources;
+
+	/** Critical section for synchronizing access to the registered sources. */
+	mutable FCriticalSection SourcesCriticalSection;
+
+	/** Maximum number of bytes in loaded chunks per stripe (zero = cache disabled). */
+	int64 StripeCapacity;
+
+	/** The cache stripes. */
+	FStripe Stripes[NumStripes];
+};
@@ -0,0 +1,106 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#include "VlcMediaPlayerClock.h"
+#include "VlcMediaPlayerPrivate.h"
+
+#include "Math/UnrealMathUtility.h"
+
+
+/* Local helpers
+ *****************************************************************************/
+
+namespace VlcMediaPlayerClock
+{
+	/** Fraction of the measured drift that is corrected per update. */
+	const double DriftCorrection = 0.2;
+
+	/** Smallest drift that causes the clock to jump to the reported time. */
+	const FTimespan ResyncThreshold = FTimespan::FromMilliseconds(250.0);
+}
+
+
+/* FVlcMediaPlayerClock structors
+ *****************************************************************************/
+
+FVlcMediaPlayerClock::FVlcMediaPlayerClock()
+	: AverageDrift(0.0)
+	, LastDrift(FTimespan::Zero())
+	, LastDecoderTime(FTimespan::MinValue())
+	, MaxDrift(FTimespan::Zero())
+	, NumResyncs(0)
+	, NumUpdates(0)
+	, Time(FTimespan::Zero())
+{ }
+
+
+/* FVlcMediaPlayerClock interface
+ *****************************************************************************/
+
+FString FVlcMediaPlayerClock::GetStats() const
+{
+	FString StatsString;
+	{
+		StatsString += TEXT("Clock\n");
+		StatsString += FString::Printf(TEXT("    Drift: %.1f ms\n"), LastDrift.GetTotalMilliseconds());
+		StatsString += FString::Printf(TEXT("    Average Drift: %.1f ms\n"), FTimespan((int64)AverageDrift).GetTotalMilliseconds());
+		StatsString += FString::Printf(TEXT("    Max Drift: %.1f ms\n"), MaxDrift.GetTotalMilliseconds());
+		StatsString += FString::Printf(TEXT("    Updates: %i\n"), NumUpdates);
+		StatsString += FString::Printf(TEXT("    Resyncs: %i\n"), NumResyncs);
+		StatsString += TEXT("\n");
+	}
+
+	return StatsString;
+}
+
+
+void FVlcMediaPlayerClock::Reset(FTimespan NewTime)
+{
+	Time = NewTime;
+
+	// LastDecoderTime is kept, so that a time reported before the reset is
+	// not mistaken for a new one; the next change resynchronizes the clock
+}
+
+
+void FVlcMediaPlayerClock::Tick(FTimespan DeltaTime, float Rate, FTimespan DecoderTime)
+{
+	const FTimespan PredictedTime = Time + DeltaTime * Rate;
+
+	if ((DecoderTime < FTimespan::Zero()) || (DecoderTime == LastDecoderTime))
+	{
+		Time = PredictedTime; // no new information; interpolate
+		return;
+	}
+
+	LastDecoderTime = DecoderTime;
+
+	const FTimespan Drift = DecoderTime - PredictedTime;
+	const int64 AbsDriftTicks = FMath::Abs(Drift.GetTicks());
+
+	if (AbsDriftTicks >= VlcMediaPlayerClock::ResyncThreshold.GetTicks())
+	{
+		UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Clock %p: Resynchronizing from %s to %s"), this, *PredictedTime.ToString(), *DecoderTime.ToString());
+
+		Time = DecoderTime;
+		++NumResyncs;
+
+		return;
+	}
+
+	// correct drift gradually, without going backwards while playing
+	FTimespan CorrectedTime = PredictedTime + FTimespan((int64)(Drift.GetTicks() * VlcMediaPlayerClock::DriftCorrection));
+
+	if ((Rate > 0.0f) && (CorrectedTime < Time))
+	{
+		CorrectedTime = Time;
+	}
+
+	Time = CorrectedTime;
+
+	// update statistics
+	++NumUpdates;
+
+	AverageDrift += (AbsDriftTicks - AverageDrift) / NumUpdates;
+	LastDrift = Drift;
+	MaxDrift = FTimespan(FMath::Max(MaxDrift.GetTicks(), AbsDriftTicks));
+}
@@ -0,0 +1,86 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Containers/UnrealString.h"
+#include "Misc/Timespan.h"
+
+
+/**
+ * Implements the play time of VLC based media players.
+ *
+ * The time that VLC reports for its input is updated at irregular intervals and in
+ * millisecond steps, so the clock interpolates between updates using the game's
+ * frame time. Each time VLC reports a new time, the difference to the interpolated
+ * time (the drift) is measured and gradually corrected. Large differences, such as
+ * after seeks or stalls, cause the clock to jump to the reported time instead.
+ */
+class FVlcMediaPlayerClock
+{
+public:
+
+	/** Default constructor. */
+	FVlcMediaPlayerClock();
+
+public:
+
+	/**
+	 * Get clock statistics.
+	 *
+	 * @return Statistics string.
+	 */
+	FString GetStats() const;
+
+	/**
+	 * Get the current play time.
+	 *
+	 * @return Play time.
+	 */
+	FTimespan GetTime() const
+	{
+		return Time;
+	}
+
+	/**
+	 * Set the clock to the specified time.
+	 *
+	 * Use this method when the play time changes for reasons the decoder has not
+	 * reported yet, i.e. when seeking or restarting playback.
+	 *
+	 * @param NewTime The time to set.
+	 */
+	void Reset(FTimespan NewTime);
+
+	/**
+	 * Advance the clock by one game tick.
+	 *
+	 * @param DeltaTime Time since the last tick.
+	 * @param Rate The current play rate.
+	 * @param DecoderTime The time reported by VLC, or a negative value if unknown.
+	 */
+	void Tick(FTimespan DeltaTime, float Rate, FTimespan DecoderTime);
+
+private:
+
+	/** Mean absolute drift over all updates (in ticks). */
+	double AverageDrift;
+
+	/** Drift measured at the most recent update. */
+	FTimespan LastDrift;
+
+	/** The time reported by VLC at the most recent update. */
+	FTimespan LastDecoderTime;
+
+	/** Largest absolute drift that was corrected gradually. */
+	FTimespan MaxDrift;
+
+	/** Number of times that the clock jumped to the reported time. */
+	int32 NumResyncs;
+
+	/** Number of times that VLC reported a new time. */
+	int32 NumUpdates;
+
+	/** The current play time. */
+	FTimespan Time;
+};
@@ -0,0 +1,346 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#include "VlcMediaPlayerColorConverter.h"
+
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/UnrealMemory.h"
+#include "Math/UnrealMathUtility.h"
+
+#if PLATFORM_CPU_X86_FAMILY
+	#include <immintrin.h>
+
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+	#endif
+
+	#if defined(__clang__) || defined(__GNUC__)
+		#define VLCMEDIAPLAYER_TARGET_AVX2 __attribute__((target("avx2")))
+		#define VLCMEDIAPLAYER_TARGET_SSE4_1 __attribute__((target("sse4.1")))
+	#else
+		#define VLCMEDIAPLAYER_TARGET_AVX2
+		#define VLCMEDIAPLAYER_TARGET_SSE4_1
+	#endif
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+	#include <arm_neon.h>
+#endif
+
+
+/* Local helpers
+ *****************************************************************************/
+
+namespace VlcMediaPlayerColorConverter
+{
+	/** Minimum number of row pairs that are worth converting on a separate task. */
+	const int32 MinRowPairsPerStripe = 32;
+
+	/** Fixed-point precision of the conversion coefficients (in bits). */
+	const int32 Precision = 14;
+
+	/** Converts one row of pixels. */
+	typedef void (*FRowKernel)(const uint8* Y, const uint8* Cb, const uint8* Cr, uint8* Dest, int32 Width, const FVlcMediaPlayerColorCoefficients& C);
+
+	/** A named row conversion kernel. */
+	struct FKernel
+	{
+		/** The kernel's row conversion function. */
+		FRowKernel Function;
+
+		/** The kernel's name (for statistics). */
+		const TCHAR* Name;
+	};
+
+	/** Clamp a fixed-point color component to 8 bits. */
+	FORCEINLINE uint8 ClampComponent(int32 Value)
+	{
+		return (uint8)FMath::Clamp(Value >> Precision, 0, 255);
+	}
+
+	/** Portable row conversion kernel. */
+	void ConvertRowScalar(const uint8* Y, const uint8* Cb, const uint8* Cr, uint8* Dest, int32 Width, const FVlcMediaPlayerColorCoefficients& C)
+	{
+		for (int32 X = 0; X < Width; ++X)
+		{
+			const int32 Luma = (Y[X] - C.YOffset) * C.YScale + (1 << (Precision - 1));
+			const int32 U = Cb[X / 2] - 128;
+			const int32 V = Cr[X / 2] - 128;
+
+			Dest[0] = ClampComponent(Luma + C.CbToB * U);
+			Dest[1] = ClampComponent(Luma - C.CbToG * U - C.CrToG * V);
+			Dest[2] = ClampComponent(Luma + C.CrToR * V);
+			Dest[3] = 255;
+
+			Dest += 4;
+		}
+	}
+
+#if PLATFORM_CPU_X86_FAMILY
+
+	/** Row conversion kernel that converts four pixels at a time using SSE4.1. */
+	VLCMEDIAPLAYER_TARGET_SSE4_1 void ConvertRowSse41(const uint8* Y, const uint8* Cb, const uint8* Cr, uint8* Dest, int32 Width, const FVlcMediaPlayerColorCoefficients& C)
+	{
+		const __m128i Alpha = _mm_set1_epi32(255);
+		const __m128i Bias = _mm_set1_epi32(128);
+		const __m128i CbToB = _mm_set1_epi32(C.CbToB);
+		const __m128i CbToG = _mm_set1_epi32(C.CbToG);
+		const __m128i CrToG = _mm_set1_epi32(C.CrToG);
+		const __m128i CrToR = _mm_set1_epi32(C.CrToR);
+		const __m128i Round = _mm_set1_epi32(1 << (Precision - 1));
+		const __m128i YOffset = _mm_set1_epi32(C.YOffset);
+		const __m128i YScale = _mm_set1_epi32(C.YScale);
+
+		// RRRRGGGGBBBBAAAA -> BGRABGRABGRABGRA
+		const __m128i Interleave = _mm_setr_epi8(8, 4, 0, 12, 9, 5, 1, 13, 10, 6, 2, 14, 11, 7, 3, 15);
+
+		int32 X = 0;
+
+		for (; X + 4 <= Width; X += 4)
+		{
+			int32 YBits;
+			uint16 CbBits, CrBits;
+
+			FMemory::Memcpy(&YBits, Y + X, 4);
+			FMemory::Memcpy(&CbBits, Cb + X / 2, 2);
+			FMemory::Memcpy(&CrBits, Cr + X / 2, 2);
+
+			// each chroma sample covers two pixels
+			const __m128i CbPairs = _mm_cvtsi32_si128(CbBits);
+			const __m128i CrPairs = _mm_cvtsi32_si128(CrBits);
+			const __m128i U = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_unpacklo_epi8(CbPairs, CbPairs)), Bias);
+			const __m128i V = _mm_sub_epi32(_mm_cvtepu8_epi32(_mm_unpacklo_epi8(CrPairs, CrPairs)), Bias);
+
+			const __m128i Luma = _mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(YBits)), YOffset), YScale), Round);
+
+			const __m128i R = _mm_srai_epi32(_mm_add_epi32(Luma, _mm_mullo_epi32(V, CrToR)), Precision);
+			const __m128i G = _mm_srai_epi32(_mm_sub_epi32(_mm_sub_epi32(Luma, _mm_mullo_epi32(U, CbToG)), _mm_mullo_epi32(V, CrToG)), Precision);
+			const __m128i B = _mm_srai_epi32(_mm_add_epi32(Luma, _mm_mullo_epi32(U, CbToB)), Precision);
+
+			const __m128i Packed = _mm_packus_epi16(_mm_packs_epi32(R, G), _mm_packs_epi32(B, Alpha));
+			_mm_storeu_si128((__m128i*)(Dest + X * 4), _mm_shuffle_epi8(Packed, Interleave));
+		}
+
+		ConvertRowScalar(Y + X, Cb + X / 2, Cr + X / 2, Dest + X * 4, Width - X, C);
+	}
+
+	/** Row conversion kernel that converts eight pixels at a time using AVX2. */
+	VLCMEDIAPLAYER_TARGET_AVX2 void ConvertRowAvx2(const uint8* Y, const uint8* Cb, const uint8* Cr, uint8* Dest, int32 Width, const FVlcMediaPlayerColorCoefficients& C)
+	{
+		const __m256i Alpha = _mm256_set1_epi32(255);
+		const __m256i Bias = _mm256_set1_epi32(128);
+		const __m256i CbToB = _mm256_set1_epi32(C.CbToB);
+		const __m256i CbToG = _mm256_set1_epi32(C.CbToG);
+		const __m256i CrToG = _mm256_set1_epi32(C.CrToG);
+		const __m256i CrToR = _mm256_set1_epi32(C.CrToR);
+		const __m256i Round = _mm256_set1_epi32(1 << (Precision - 1));
+		const __m256i YOffset = _mm256_set1_epi32(C.YOffset);
+		const __m256i YScale = _mm256_set1_epi32(C.YScale);
+
+		// packing works on 128-bit lanes, so each lane holds four pixels
+		const __m256i Interleave = _mm256_setr_epi8(
+			8, 4, 0, 12, 9, 5, 1, 13, 10, 6, 2, 14, 11, 7, 3, 15,
+			8, 4, 0, 12, 9, 5, 1, 13, 10, 6, 2, 14, 11, 7, 3, 15);
+
+		int32 X = 0;
+
+		for (; X + 8 <= Width; X += 8)
+		{
+			int32 CbBits, CrBits;
+
+			FMemory::Memcpy(&CbBits, Cb + X / 2, 4);
+			FMemory::Memcpy(&CrBits, Cr + X / 2, 4);
+
+			const __m128i CbPairs = _mm_cvtsi32_si128(CbBits);
+			const __m128i CrPairs = _mm_cvtsi32_si128(CrBits);
+			const __m256i U = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_unpacklo_epi8(CbPairs, CbPairs)), Bias);
+			const __m256i V = _mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_unpacklo_epi8(CrPairs, CrPairs)), Bias);
+
+			const __m256i Luma = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(Y + X))), YOffset), YScale), Round);
+
+			const __m256i R = _mm256_srai_epi32(_mm256_add_epi32(Luma, _mm256_mullo_epi32(V, CrToR)), Precision);
+			const __m256i G = _mm256_srai_epi32(_mm256_sub_epi32(_mm256_sub_epi32(Luma, _mm256_mullo_epi32(U, CbToG)), _mm256_mullo_epi32(V, CrToG)), Precision);
+			const __m256i B = _mm256_srai_epi32(_mm256_add_epi32(Luma, _mm256_mullo_epi32(U, CbToB)), Precision);
+
+			const __m256i Packed = _mm256_packus_epi16(_mm256_packs_epi32(R, G), _mm256_packs_epi32(B, Alpha));
+			_mm256_storeu_si256((__m256i*)(Dest + X * 4), _mm256_shuffle_epi8(Packed, Interleave));
+		}
+
+		ConvertRowSse41(Y + X, Cb + X / 2, Cr + X / 2, Dest + X * 4, Width - X, C);
+	}
+
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+
+	/** Convert four pixels to fixed-point RGB. */
+	FORCEINLINE void ConvertQuadNeon(int16x4_t Y, int16x4_t U, int16x4_t V, const FVlcMediaPlayerColorCoefficients& C, int32x4_t& OutR, int32x4_t& OutG, int32x4_t& OutB)
+	{
+		const int32x4_t Cb = vmovl_s16(U);
+		const int32x4_t Cr = vmovl_s16(V);
+		const int32x4_t Luma = vmlaq_n_s32(vdupq_n_s32(1 << (Precision - 1)), vsubq_s32(vmovl_s16(Y), vdupq_n_s32(C.YOffset)), C.YScale);
+
+		OutR = vshrq_n_s32(vmlaq_n_s32(Luma, Cr, C.CrToR), Precision);
+		OutG = vshrq_n_s32(vmlsq_n_s32(vmlsq_n_s32(Luma, Cb, C.CbToG), Cr, C.CrToG), Precision);
+		OutB = vshrq_n_s32(vmlaq_n_s32(Luma, Cb, C.CbToB), Precision);
+	}
+
+	/** Row conversion kernel that converts eight pixels at a time using NEON. */
+	void ConvertRowNeon(const uint8* Y, const uint8* Cb, const uint8* Cr, uint8* Dest, int32 Width, const FVlcMediaPlayerColorCoefficients& C)
+	{
+		const int16x8_t Bias = vdupq_n_s16(128);
+
+		int32 X = 0;
+
+		for (; X + 8 <= Width; X += 8)
+		{
+			uint32 CbBits, CrBits;
+
+			FMemory::Memcpy(&CbBits, Cb + X / 2, 4);
+			FMemory::Memcpy(&CrBits, Cr + X / 2, 4);
+
+			// each chroma sample covers two pixels
+			const uint8x8_t CbQuad = vreinterpret_u8_u32(vdup_n_u32(CbBits));
+			const uint8x8_t CrQuad = vreinterpret_u8_u32(vdup_n_u32(CrBits));
+			const int16x8_t U = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vzip_u8(CbQuad, CbQuad).val[0])), Bias);
+			const int16x8_t V = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vzip_u8(CrQuad, CrQuad).val[0])), Bias);
+			const int16x8_t Luma = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(Y + X)));
+
+			int32x4_t RLow, GLow, BLow, RHigh, GHigh, BHigh;
+
+			ConvertQuadNeon(vget_low_s16(Luma), vget_low_s16(U), vget_low_s16(V), C, RLow, GLow, BLow);
+			ConvertQuadNeon(vget_high_s16(Luma), vget_high_s16(U), vget_high_s16(V), C, RHigh, GHigh, BHigh);
+
+			uint8x8x4_t Pixels;
+			{
+				Pixels.val[0] = vqmovun_s16(vcombine_s16(vqmovn_s32(BLow), vqmovn_s32(BHigh)));
+				Pixels.val[1] = vqmovun_s16(vcombine_s16(vqmovn_s32(GLow), vqmovn_s32(GHigh)));
+				Pixels.val[2] = vqmovun_s16(vcombine_s16(vqmovn_s32(RLow), vqmovn_s32(RHigh)));
+				Pixels.val[3] = vdup_n_u8(255);
+			}
+
+			vst4_u8(Dest + X * 4, Pixels);
+		}
+
+		ConvertRowScalar(Y + X, Cb + X / 2, Cr + X / 2, Dest + X * 4, Width - X, C);
+	}
+
+#endif
+
+#if PLATFORM_CPU_X86_FAMILY
+
+	/** Check whether the CPU supports SSE4.1 (not all x86 builds require it). */
+	bool HasSse41InstructionSupport()
+	{
+	#if PLATFORM_ALWAYS_HAS_SSE4_1
+		return true;
+	#elif defined(_MSC_VER)
+		int32 Info[4];
+		__cpuid(Info, 1);
+
+		return ((Info[2] & (1 << 19)) != 0);
+	#else
+		return __builtin_cpu_supports("sse4.1");
+	#endif
+	}
+
+#endif
+
+	/** Get the fixed-point coefficients for a conversion matrix and range. */
+	FVlcMediaPlayerColorCoefficients GetCoefficients(EVlcMediaPlayerColorMatrix Matrix, bool FullRange)
+	{
+		// coefficients are scaled by 2^14; limited range coefficients include the 255/219 and 255/224 expansion
+		if (Matrix == EVlcMediaPlayerColorMatrix::Bt709)
+		{
+			return FullRange
+				? FVlcMediaPlayerColorCoefficients{ 25802, 3069, 7670, 30402, 16384, 0 }
+				: FVlcMediaPlayerColorCoefficients{ 29372, 3494, 8731, 34610, 19077, 16 };
+		}
+
+		return FullRange
+			? FVlcMediaPlayerColorCoefficients{ 22970, 5638, 11700, 29032, 16384, 0 }
+			: FVlcMediaPlayerColorCoefficients{ 26149, 6419, 13320, 33050, 19077, 16 };
+	}
+
+	/** Select the fastest kernel supported by this CPU. */
+	FKernel SelectKernel()
+	{
+#if PLATFORM_CPU_X86_FAMILY
+		if (FPlatformMisc::HasAVX2InstructionSupport())
+		{
+			return { &ConvertRowAvx2, TEXT("AVX2") };
+		}
+
+		if (HasSse41InstructionSupport())
+		{
+			return { &ConvertRowSse41, TEXT("SSE4.1") };
+		}
+#elif PLATFORM_CPU_ARM_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+		return { &ConvertRowNeon, TEXT("NEON") };
+#endif
+
+		return { &ConvertRowScalar, TEXT("Scalar") };
+	}
+
+	/** Get the kernel used on this CPU. */
+	const FKernel& GetKernel()
+	{
+		static const FKernel Kernel = SelectKernel();
+		return Kernel;
+	}
+}
+
+
+/* FVlcMediaPlayerColorConverter structors
+ *****************************************************************************/
+
+FVlcMediaPlayerColorConverter::FVlcMediaPlayerColorConverter()
+{
+	Configure(EVlcMediaPlayerColorMatrix::Bt601, false);
+}
+
+
+/* FVlcMediaPlayerColorConverter interface
+ *****************************************************************************/
+
+void FVlcMediaPlayerColorConverter::Configure(EVlcMediaPlayerColorMatrix Matrix, bool FullRange)
+{
+	Coefficients = VlcMediaPlayerColorConverter::GetCoefficients(Matrix, FullRange);
+}
+
+
+void FVlcMediaPlayerColorConverter::Convert(const uint8* const* Planes, const uint32* Pitches, uint8* Dest, uint32 DestPitch, const FIntPoint& Dim) const
+{
+	if ((Dim.X <= 0) || (Dim.Y <= 0))
+	{
+		return;
+	}
+
+	const VlcMediaPlayerColorConverter::FRowKernel Kernel = VlcMediaPlayerColorConverter::GetKernel().Function;
+
+	// stripes start on even rows, so that they don't share chroma rows
+	const int32 RowPairs = (Dim.Y + 1) / 2;
+	const int32 MaxStripes = FTaskGraphInterface::IsRunning() ? FTaskGraphInterface::Get().GetNumWorkerThreads() + 1 : 1;
+	const int32 NumStripes = FMath::Clamp(RowPairs / VlcMediaPlayerColorConverter::MinRowPairsPerStripe, 1, MaxStripes);
+
+	ParallelFor(NumStripes, [&](int32 Stripe)
+	{
+		const int32 FirstRow = 2 * (RowPairs * Stripe / NumStripes);
+		const int32 LastRow = FMath::Min(2 * (RowPairs * (Stripe + 1) / NumStripes), Dim.Y);
+
+		for (int32 Row = FirstRow; Row < LastRow; ++Row)
+		{
+			Kernel(
+				Planes[0] + Row * Pitches[0],
+				Planes[1] + (Row / 2) * Pitches[1],
+				Planes[2] + (Row / 2) * Pitches[2],
+				Dest + Row * DestPitch,
+				Dim.X,
+				Coefficients
+			);
+		}
+	});
+}
+
+
+const TCHAR* FVlcMediaPlayerColorConverter::GetKernelName()
+{
+	return VlcMediaPlayerColorConverter::GetKernel().Name;
+}
@@ -0,0 +1,95 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Math/IntPoint.h"
+
+
+/**
+ * Available YCbCr to RGB conversion matrices.
+ */
+enum class EVlcMediaPlayerColorMatrix : uint8
+{
+	/** ITU-R BT.601 (standard definition video). */
+	Bt601,
+
+	/** ITU-R BT.709 (high definition video). */
+	Bt709,
+};
+
+
+/**
+ * Fixed-point coefficients for converting YCbCr pixels to RGB.
+ *
+ * All factors are scaled by 2^14.
+ */
+struct FVlcMediaPlayerColorCoefficients
+{
+	/** Red contribution of Cr. */
+	int32 CrToR;
+
+	/** Green contribution of Cb (subtracted). */
+	int32 CbToG;
+
+	/** Green contribution of Cr (subtracted). */
+	int32 CrToG;
+
+	/** Blue contribution of Cb. */
+	int32 CbToB;
+
+	/** Luma scale factor. */
+	int32 YScale;
+
+	/** Luma offset (16 for limited range, 0 for full range). */
+	int32 YOffset;
+};
+
+
+/**
+ * Converts planar 4:2:0 YCbCr video frames to BGRA.
+ *
+ * The conversion uses the fastest kernel that the CPU supports (AVX2, SSE4.1 or NEON,
+ * with a portable fallback). Frames are split into stripes of rows that are converted
+ * in parallel on the task graph.
+ */
+class FVlcMediaPlayerColorConverter
+{
+public:
+
+	/** Default constructor. */
+	FVlcMediaPlayerColorConverter();
+
+public:
+
+	/**
+	 * Set the conversion matrix and range.
+	 *
+	 * @param Matrix The YCbCr to RGB conversion matrix.
+	 * @param FullRange Whether the input uses full range (0-255) instead of limited range (16-235) values.
+	 */
+	void Configure(EVlcMediaPlayerColorMatrix Matrix, bool FullRange);
+
+	/**
+	 * Convert a frame.
+	 *
+	 * @param Planes Pointers to the Y, Cb and Cr planes.
+	 * @param Pitches Row pitches of the Y, Cb and Cr planes (in bytes).
+	 * @param Dest The buffer to write the BGRA pixels to.
+	 * @param DestPitch Row pitch of the destination buffer (in bytes).
+	 * @param Dim Width and height of the frame (in pixels).
+	 */
+	void Convert(const uint8* const* Planes, const uint32* Pitches, uint8* Dest, uint32 DestPitch, const FIntPoint& Dim) const;
+
+	/**
+	 * Get the name of the conversion kernel used on this CPU.
+	 *
+	 * @return Kernel name.
+	 */
+	static const TCHAR* GetKernelName();
+
+private:
+
+	/** The coefficients for the current matrix and range. */
+	FVlcMediaPlayerColorCoefficients Coefficients;
+};
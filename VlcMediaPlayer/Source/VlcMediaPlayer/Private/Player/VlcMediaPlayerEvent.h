@@ -0,0 +1,69 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+
+#include "VlcWrapper.h"
+
+
+/**
+ * A VLC event and its payload, as received on VLC's event thread.
+ *
+ * Only the payload fields that belong to the event's type are valid.
+ */
+struct FVlcMediaPlayerEvent
+{
+	/** Buffer fill level (in percent, for Buffering events). */
+	float BufferFill;
+
+	/** Identifier of the elementary stream (for ES events). */
+	int32 EsId;
+
+	/** The event type. */
+	libvlc_event_e Type;
+
+	/** Number of video outputs (for Vout events). */
+	int32 VoutCount;
+
+public:
+
+	/** Default constructor. */
+	FVlcMediaPlayerEvent()
+		: BufferFill(0.0f)
+		, EsId(-1)
+		, Type(libvlc_event_e::libvlc_MediaPlayerNothingSpecial)
+		, VoutCount(0)
+	{ }
+
+	/**
+	 * Create and initialize a new instance from a VLC event.
+	 *
+	 * @param Event The VLC event.
+	 */
+	explicit FVlcMediaPlayerEvent(const libvlc_event_t& Event)
+		: FVlcMediaPlayerEvent()
+	{
+		Type = static_cast<libvlc_event_e>(Event.type);
+
+		switch (Type)
+		{
+		case libvlc_event_e::libvlc_MediaPlayerBuffering:
+			BufferFill = Event.u.media_player_buffering.new_cache;
+			break;
+
+		case libvlc_event_e::libvlc_MediaPlayerESAdded:
+		case libvlc_event_e::libvlc_MediaPlayerESDeleted:
+		case libvlc_event_e::libvlc_MediaPlayerESSelected:
+			EsId = Event.u.media_player_es_changed.i_id;
+			break;
+
+		case libvlc_event_e::libvlc_MediaPlayerVout:
+			VoutCount = Event.u.media_player_vout.new_count;
+			break;
+
+		default:
+			break;
+		}
+	}
+};
@@ -0,0 +1,377 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#include "VlcMediaPlayerOpenTask.h"
+#include "VlcMediaPlayerPrivate.h"
+
+#include "Async/Async.h"
+#include "HAL/Event.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/Class.h"
+
+#include "VlcMediaPlayerPrecache.h"
+#include "VlcMediaPlayerReaper.h"
+#include "VlcMediaPlayerSource.h"
+
+
+/* Local helpers
+ *****************************************************************************/
+
+namespace VlcMediaPlayerOpenTask
+{
+	/** Additional time to wait for VLC to report a parse timeout. */
+	const FTimespan ParseTimeoutGrace = FTimespan::FromSeconds(1.0);
+}
+
+
+/* FVlcMediaPlayerOpenTask static initialization
+ *****************************************************************************/
+
+std::atomic<int32> FVlcMediaPlayerOpenTask::NumRunning(0);
+
+
+/* FVlcMediaPlayerOpenTask structors
+ *****************************************************************************/
+
+FVlcMediaPlayerOpenTask::FVlcMediaPlayerOpenTask(libvlc_instance_t* InVlcInstance, const FString& InUrl, const TSharedPtr<FArchive, ESPMode::ThreadSafe>& InArchive, bool InPrecache, const TArray<FString>& InInputOptions)
+	: Archive(InArchive)
+	, Canceled(false)
+	, InputOptions(InInputOptions)
+	, Opened(false)
+	, ParseTimeout(GetDefault<UVlcMediaPlayerSettings>()->ParseTimeout)
+	, ParsedEvent(FPlatformProcess::GetSynchEventFromPool(true))
+	, Player(nullptr)
+	, Precache(InPrecache)
+	, Reusing(false)
+	, Stage(EStage::Queued)
+	, Url(InUrl)
+	, VlcInstance(InVlcInstance)
+{ }
+
+
+FVlcMediaPlayerOpenTask::~FVlcMediaPlayerOpenTask()
+{
+	ReleaseResults();
+	FPlatformProcess::ReturnSynchEventToPool(ParsedEvent);
+}
+
+
+/* FVlcMediaPlayerOpenTask interface
+ *****************************************************************************/
+
+void FVlcMediaPlayerOpenTask::Cancel()
+{
+	Canceled = true;
+	ParsedEvent->Trigger();
+
+	FScopeLock Lock(&CriticalSection);
+
+	if (IsCompleted())
+	{
+		ReleaseResults();
+	}
+}
+
+
+bool FVlcMediaPlayerOpenTask::Finish(TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe>& OutSource, libvlc_media_player_t*& OutPlayer)
+{
+	check(IsCompleted());
+
+	FScopeLock Lock(&CriticalSection);
+
+	if (!Opened || (Player == nullptr))
+	{
+		return false;
+	}
+
+	OutPlayer = Player;
+	OutSource = MoveTemp(Source);
+	Callbacks.Reset();
+	Player = nullptr;
+
+	return true;
+}
+
+
+float FVlcMediaPlayerOpenTask::GetProgress() const
+{
+	switch (Stage.load())
+	{
+	case EStage::Reading:
+		return 0.25f;
+
+	case EStage::Creating:
+		return 0.5f;
+
+	case EStage::Parsing:
+		return 0.75f;
+
+	case EStage::Completed:
+		return 1.0f;
+
+	default:
+		return 0.0f;
+	}
+}
+
+
+void FVlcMediaPlayerOpenTask::ReusePlayer(libvlc_media_player_t* InPlayer, const TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe>& InPreviousSource, const TSharedPtr<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe>& InCallbacks, const FVlcMediaPlayerCallbacks::FVideoSettings& InVideoSettings)
+{
+	check(!IsStarted());
+
+	Callbacks = InCallbacks;
+	Player = InPlayer;
+	PreviousSource = InPreviousSource;
+	Reusing = true;
+	VideoSettings = InVideoSettings;
+}
+
+
+bool FVlcMediaPlayerOpenTask::Start()
+{
+	if (IsStarted())
+	{
+		return true;
+	}
+
+	const int32 MaxRunning = FMath::Max(1, GetDefault<UVlcMediaPlayerSettings>()->MaxConcurrentOpens);
+	int32 Running = NumRunning.load();
+
+	do
+	{
+		if (Running >= MaxRunning)
+		{
+			return false;
+		}
+	}
+	while (!NumRunning.compare_exchange_weak(Running, Running + 1));
+
+	Stage = EStage::Reading;
+
+	Async(EAsyncExecution::Thread, [Task = AsShared()]()
+	{
+		Task->Run();
+	});
+
+	return true;
+}
+
+
+/* FVlcMediaPlayerOpenTask implementation
+ *****************************************************************************/
+
+bool FVlcMediaPlayerOpenTask::OpenMedia()
+{
+	Source = MakeShared<FVlcMediaPlayerSource, ESPMode::ThreadSafe>(VlcInstance, InputOptions);
+
+	// open local files via platform file system
+	const bool LocalFile = !Archive.IsValid() && Url.StartsWith(TEXT("file://"));
+	bool SourceOpened = false;
+
+	if (LocalFile && !Precache && GetDefault<UVlcMediaPlayerSettings>()->MapLocalFiles)
+	{
+		// files that cannot be mapped are read through an archive instead
+		SourceOpened = (Source->OpenMappedFile(&Url[7], Url) != nullptr);
+	}
+
+	TSharedPtr<FVlcMediaPlayerPrecache, ESPMode::ThreadSafe> PrecacheFile;
+
+	if (LocalFile && !SourceOpened)
+	{
+		const TCHAR* FilePath = &Url[7];
+		TUniquePtr<FArchive> FileReader(IFileManager::Get().CreateFileReader(FilePath));
+
+		if (!FileReader.IsValid())
+		{
+			UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Failed to open media file: %s"), FilePath);
+			return false;
+		}
+
+		// precached files are loaded in the background while VLC reads what's already in memory
+		if (Precache)
+		{
+			PrecacheFile = MakeShared<FVlcMediaPlayerPrecache, ESPMode::ThreadSafe>(MoveTemp(FileReader), FilePath);
+			Archive = PrecacheFile;
+		}
+		else
+		{
+			Archive = MakeShareable(FileReader.Release());
+		}
+	}
+
+	if (Canceled)
+	{
+		return false;
+	}
+
+	Stage = EStage::Creating;
+
+	// create media source & player
+	if (!SourceOpened)
+	{
+		if (PrecacheFile.IsValid())
+		{
+			SourceOpened = (Source->OpenPrecachedFile(PrecacheFile.ToSharedRef(), Url) != nullptr);
+		}
+		else
+		{
+			SourceOpened = Archive.IsValid()
+				? (Source->OpenArchive(Archive.ToSharedRef(), Url) != nullptr)
+				: (Source->OpenUrl(Url) != nullptr);
+		}
+	}
+
+	if (!SourceOpened)
+	{
+		return false;
+	}
+
+	if (Reusing)
+	{
+		// stops the previous input, but keeps the player's outputs
+		const double SwitchStartTime = FPlatformTime::Seconds();
+
+		libvlc_media_player_set_media(Player, Source->GetMedia());
+
+		PreviousSource->Close();
+		PreviousSource.Reset();
+
+		// the previous input no longer produces frames, but the player's video output is kept
+		Callbacks->ConfigureQueue(VideoSettings);
+
+		UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Open task %p: Switched media of player %p in %.1f ms"), this, Player, (FPlatformTime::Seconds() - SwitchStartTime) * 1000.0);
+	}
+	else
+	{
+		Player = libvlc_media_player_new_from_media(Source->GetMedia());
+
+		if (Player == nullptr)
+		{
+			UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Failed to initialize media player: %s"), ANSI_TO_TCHAR(libvlc_errmsg()));
+			return false;
+		}
+	}
+
+	if (Canceled)
+	{
+		return false;
+	}
+
+	Stage = EStage::Parsing;
+
+	return ParseMedia();
+}
+
+
+bool FVlcMediaPlayerOpenTask::ParseMedia()
+{
+	libvlc_media_t* Media = Source->GetMedia();
+	libvlc_event_manager_t* MediaEventManager = libvlc_media_event_manager(Media);
+
+	if (MediaEventManager == nullptr)
+	{
+		return false;
+	}
+
+	libvlc_event_attach(MediaEventManager, libvlc_event_e::libvlc_MediaParsedChanged, &FVlcMediaPlayerOpenTask::StaticParsedCallback, this);
+
+	const int32 TimeoutMs = FMath::Max(1, (int32)ParseTimeout.GetTotalMilliseconds());
+	const libvlc_media_parse_flag_t ParseFlags = (libvlc_media_parse_flag_t)(libvlc_media_parse_local | libvlc_media_parse_network);
+
+	if (libvlc_media_parse_with_options(Media, ParseFlags, TimeoutMs) == -1)
+	{
+		UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Failed to parse media %s: %s"), *Url, ANSI_TO_TCHAR(libvlc_errmsg()));
+	}
+	else if (!ParsedEvent->Wait(ParseTimeout + VlcMediaPlayerOpenTask::ParseTimeoutGrace) || Canceled)
+	{
+		libvlc_media_parse_stop(Media);
+	}
+
+	libvlc_event_detach(MediaEventManager, libvlc_event_e::libvlc_MediaParsedChanged, &FVlcMediaPlayerOpenTask::StaticParsedCallback, this);
+
+	if (Canceled)
+	{
+		return false;
+	}
+
+	switch (libvlc_media_get_parsed_status(Media))
+	{
+	case libvlc_media_parsed_status_done:
+	case libvlc_media_parsed_status_skipped:
+		return true;
+
+	case libvlc_media_parsed_status_failed:
+		UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Failed to parse media %s"), *Url);
+		return false;
+
+	default:
+		// streams that cannot be parsed in time may still be playable
+		UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Timed out parsing media %s, opening it anyway"), *Url);
+		return true;
+	}
+}
+
+
+void FVlcMediaPlayerOpenTask::ReleaseResults()
+{
+	if ((Player != nullptr) && Reusing)
+	{
+		// the reused player may still be playing, either the previous or the new source
+		TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe>& PlayerSource = PreviousSource.IsValid() ? PreviousSource : Source;
+
+		FVlcMediaPlayerReaper::Get().Reap(Player, PlayerSource, Callbacks);
+		PlayerSource.Reset();
+		Player = nullptr;
+	}
+	else if (Player != nullptr)
+	{
+		libvlc_media_player_release(Player);
+		Player = nullptr;
+	}
+
+	Callbacks.Reset();
+
+	if (Source.IsValid())
+	{
+		Source->Close();
+		Source.Reset();
+	}
+}
+
+
+void FVlcMediaPlayerOpenTask::Run()
+{
+	const double StartTime = FPlatformTime::Seconds();
+	const bool Succeeded = OpenMedia();
+
+	UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Open task %p: %s %s in %.1f ms"), this, Succeeded ? TEXT("Opened") : TEXT("Failed to open"), *Url, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		Opened = Succeeded;
+
+		if (Canceled || !Succeeded)
+		{
+			ReleaseResults();
+		}
+
+		Stage = EStage::Completed;
+	}
+
+	--NumRunning;
+}
+
+
+/* FVlcMediaPlayerOpenTask static functions
+ *****************************************************************************/
+
+void FVlcMediaPlayerOpenTask::StaticParsedCallback(const libvlc_event_t* Event, void* UserData)
+{
+	if ((Event != nullptr) && (UserData != nullptr))
+	{
+		((FVlcMediaPlayerOpenTask*)UserData)->ParsedEvent->Trigger();
+	}
+}
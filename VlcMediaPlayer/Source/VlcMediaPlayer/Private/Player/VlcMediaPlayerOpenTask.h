@@ -0,0 +1,236 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Serialization/Archive.h"
+#include "Templates/SharedPointer.h"
+
+#include "VlcMediaPlayerCallbacks.h"
+#include "VlcWrapper.h"
+
+#include <atomic>
+
+class FEvent;
+class FVlcMediaPlayerSource;
+
+
+/**
+ * Opens a media source and creates a VLC player for it on a worker thread.
+ *
+ * Reading local files, creating the VLC objects and parsing the media can block for
+ * a long time on slow storage and network shares, so the player hands this work to a
+ * task and adopts the results once the task completed. The number of tasks that run
+ * at the same time is limited by the plug-in settings; tasks beyond the limit remain
+ * queued until Start succeeds.
+ *
+ * If the task is given an existing player, the media is switched on that player, so
+ * that its audio & video outputs and the player's callbacks can be reused.
+ */
+class FVlcMediaPlayerOpenTask
+	: public TSharedFromThis<FVlcMediaPlayerOpenTask, ESPMode::ThreadSafe>
+{
+public:
+
+	/** Stages that a task goes through. */
+	enum class EStage : uint8
+	{
+		Queued,
+		Reading,
+		Creating,
+		Parsing,
+		Completed,
+	};
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InVlcInstance The LibVLC instance to use.
+	 * @param InUrl The media URL (used as the original URL if an archive is given).
+	 * @param InArchive The archive to read media data from, or nullptr to open the URL.
+	 * @param InPrecache Whether local files should be loaded into memory while they play.
+	 * @param InInputOptions VLC input options to add to the media.
+	 */
+	FVlcMediaPlayerOpenTask(libvlc_instance_t* InVlcInstance, const FString& InUrl, const TSharedPtr<FArchive, ESPMode::ThreadSafe>& InArchive, bool InPrecache, const TArray<FString>& InInputOptions);
+
+	/** Destructor. */
+	~FVlcMediaPlayerOpenTask();
+
+public:
+
+	/**
+	 * Abandon the task.
+	 *
+	 * A running task stops parsing and releases its results on the worker thread.
+	 * Results of a completed task that were not adopted are released immediately.
+	 * This method must be called on the game thread.
+	 */
+	void Cancel();
+
+	/**
+	 * Adopt the results of a completed task.
+	 *
+	 * This method must be called on the game thread, and only once the task completed.
+	 *
+	 * @param OutSource Will contain the opened media source.
+	 * @param OutPlayer Will contain the VLC player that was created for the source.
+	 * @return true if the media was opened, false otherwise.
+	 * @see IsCompleted
+	 */
+	bool Finish(TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe>& OutSource, libvlc_media_player_t*& OutPlayer);
+
+	/**
+	 * Get the progress of the task.
+	 *
+	 * @return Progress (between 0 and 1).
+	 */
+	float GetProgress() const;
+
+	/**
+	 * Get the media URL.
+	 *
+	 * @return The URL.
+	 */
+	const FString& GetUrl() const
+	{
+		return Url;
+	}
+
+	/**
+	 * Check whether the task completed.
+	 *
+	 * @return true if completed, false otherwise.
+	 */
+	bool IsCompleted() const
+	{
+		return (Stage.load() == EStage::Completed);
+	}
+
+	/**
+	 * Check whether the task switches the media of an existing player.
+	 *
+	 * @return true if a player is reused, false if a new one is created.
+	 * @see ReusePlayer
+	 */
+	bool IsReusingPlayer() const
+	{
+		return Reusing;
+	}
+
+	/**
+	 * Check whether the task was started.
+	 *
+	 * @return true if started, false if still queued.
+	 */
+	bool IsStarted() const
+	{
+		return (Stage.load() != EStage::Queued);
+	}
+
+	/**
+	 * Switch the media of an existing player instead of creating a new one.
+	 *
+	 * The task takes ownership of the player. If the task fails or is canceled, the player
+	 * is handed to the reaper together with the specified callbacks. This method must be
+	 * called before the task is started.
+	 *
+	 * @param InPlayer The player to reuse.
+	 * @param InPreviousSource The media source that the player currently plays.
+	 * @param InCallbacks The callbacks registered with the player.
+	 * @param InVideoSettings The video settings whose queue settings to apply to the callbacks once the media was switched.
+	 */
+	void ReusePlayer(libvlc_media_player_t* InPlayer, const TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe>& InPreviousSource, const TSharedPtr<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe>& InCallbacks, const FVlcMediaPlayerCallbacks::FVideoSettings& InVideoSettings);
+
+	/**
+	 * Start the task on a worker thread if the number of running tasks allows it.
+	 *
+	 * @return true if the task was started, false if it must be retried later.
+	 */
+	bool Start();
+
+protected:
+
+	/**
+	 * Open the media source and create the VLC player.
+	 *
+	 * @return true on success, false otherwise.
+	 */
+	bool OpenMedia();
+
+	/**
+	 * Parse the media, waiting for at most the configured timeout.
+	 *
+	 * @return true if the media can be played, false otherwise.
+	 */
+	bool ParseMedia();
+
+	/** Release the source and player that the task created. */
+	void ReleaseResults();
+
+	/** Executes the task on the worker thread. */
+	void Run();
+
+private:
+
+	/** Handles parsed changed events from VLC. */
+	static void StaticParsedCallback(const libvlc_event_t* Event, void* UserData);
+
+private:
+
+	/** The archive to read media data from (optional). */
+	TSharedPtr<FArchive, ESPMode::ThreadSafe> Archive;
+
+	/** The callbacks registered with a reused player. */
+	TSharedPtr<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe> Callbacks;
+
+	/** Whether the task was canceled. */
+	std::atomic<bool> Canceled;
+
+	/** Critical section for synchronizing access to the results. */
+	FCriticalSection CriticalSection;
+
+	/** VLC input options to add to the media. */
+	TArray<FString> InputOptions;
+
+	/** Whether the media was opened successfully. */
+	bool Opened;
+
+	/** Maximum time that VLC may spend parsing the media. */
+	FTimespan ParseTimeout;
+
+	/** Triggered when VLC finished parsing the media, or when the task is canceled. */
+	FEvent* ParsedEvent;
+
+	/** The VLC player that was created for the source. */
+	libvlc_media_player_t* Player;
+
+	/** Whether local files should be loaded into memory in the background. */
+	bool Precache;
+
+	/** The media source that a reused player played before the switch. */
+	TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe> PreviousSource;
+
+	/** Whether an existing player is reused. */
+	bool Reusing;
+
+	/** The media source. */
+	TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe> Source;
+
+	/** The task's current stage. */
+	std::atomic<EStage> Stage;
+
+	/** The media URL. */
+	FString Url;
+
+	/** The video settings to apply to the callbacks of a reused player. */
+	FVlcMediaPlayerCallbacks::FVideoSettings VideoSettings;
+
+	/** The LibVLC instance. */
+	libvlc_instance_t* VlcInstance;
+
+private:
+
+	/** Number of tasks that are currently running. */
+	static std::atomic<int32> NumRunning;
+};
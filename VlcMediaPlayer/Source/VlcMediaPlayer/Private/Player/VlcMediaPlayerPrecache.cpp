@@ -0,0 +1,266 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#include "VlcMediaPlayerPrecache.h"
+#include "VlcMediaPlayerPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+
+
+/* FVlcMediaPlayerPrecache structors
+ *****************************************************************************/
+
+FVlcMediaPlayerPrecache::FVlcMediaPlayerPrecache(TUniquePtr<FArchive>&& InFileReader, const FString& InFilePath)
+	: Failed(false)
+	, FilePath(InFilePath)
+	, FileReader(MoveTemp(InFileReader))
+	, FilledBytes(0)
+	, FilledEvent(FPlatformProcess::GetSynchEventFromPool())
+	, LoadEndTime(0.0)
+	, LoadStartTime(FPlatformTime::Seconds())
+	, NumChunks(0)
+	, NumRequestedChunks(0)
+	, NumStalls(0)
+	, Position(0)
+	, RequestedChunk(INDEX_NONE)
+	, StallCycles(0)
+	, Stopping(false)
+	, Thread(nullptr)
+{
+	SetIsLoading(true);
+
+	Buffer.SetNumUninitialized(FileReader->TotalSize());
+
+	NumChunks = (Buffer.Num() + ChunkSize - 1) / ChunkSize;
+	FilledChunks = MakeUnique<std::atomic<bool>[]>(NumChunks);
+
+	Thread = FRunnableThread::Create(this, TEXT("FVlcMediaPlayerPrecache"), 0, TPri_BelowNormal);
+}
+
+
+FVlcMediaPlayerPrecache::~FVlcMediaPlayerPrecache()
+{
+	if (Thread != nullptr)
+	{
+		Stopping = true;
+
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(FilledEvent);
+}
+
+
+/* FVlcMediaPlayerPrecache interface
+ *****************************************************************************/
+
+float FVlcMediaPlayerPrecache::GetProgress() const
+{
+	if (Failed || (Buffer.Num() == 0))
+	{
+		return 1.0f;
+	}
+
+	return (float)((double)FilledBytes.load() / Buffer.Num());
+}
+
+
+FString FVlcMediaPlayerPrecache::GetStats() const
+{
+	const double LoadEnd = LoadEndTime.load();
+	const double LoadSeconds = ((LoadEnd > 0.0) ? LoadEnd : FPlatformTime::Seconds()) - LoadStartTime;
+	const double MegaBytesFilled = FilledBytes.load() / (1024.0 * 1024.0);
+
+	FString StatsString;
+	{
+		StatsString += FString::Printf(TEXT("    Precached: %.1f / %.1f MB\n"), MegaBytesFilled, Buffer.Num() / (1024.0 * 1024.0));
+
+		if (LoadSeconds > 0.0)
+		{
+			StatsString += FString::Printf(TEXT("    Precache Throughput: %.1f MB/s\n"), MegaBytesFilled / LoadSeconds);
+		}
+
+		StatsString += FString::Printf(TEXT("    Precache Requested Chunks: %i\n"), NumRequestedChunks.load());
+		StatsString += FString::Printf(TEXT("    Precache Stalls: %i\n"), NumStalls.load());
+		StatsString += FString::Printf(TEXT("    Precache Stall Time: %.1f ms\n"), FPlatformTime::ToMilliseconds64(StallCycles.load()));
+	}
+
+	return StatsString;
+}
+
+
+/* FArchive interface
+ *****************************************************************************/
+
+FString FVlcMediaPlayerPrecache::GetArchiveName() const
+{
+	return FilePath;
+}
+
+
+void FVlcMediaPlayerPrecache::Seek(int64 InPos)
+{
+	Position = FMath::Clamp<int64>(InPos, 0, Buffer.Num());
+}
+
+
+void FVlcMediaPlayerPrecache::Serialize(void* Data, int64 Num)
+{
+	if (Num <= 0)
+	{
+		return;
+	}
+
+	const int64 End = Position + Num;
+
+	if (End > Buffer.Num())
+	{
+		SetError();
+		return;
+	}
+
+	// wait for the worker to fill the chunks that cover the requested bytes
+	if (FilledBytes.load() < Buffer.Num())
+	{
+		const int64 LastChunk = (End - 1) / ChunkSize;
+		uint32 WaitStartCycles = 0;
+
+		for (int64 ChunkIndex = Position / ChunkSize; ChunkIndex <= LastChunk; ++ChunkIndex)
+		{
+			if (FilledChunks[ChunkIndex])
+			{
+				continue;
+			}
+
+			if (WaitStartCycles == 0)
+			{
+				WaitStartCycles = FPlatformTime::Cycles();
+				++NumStalls;
+			}
+
+			while (!FilledChunks[ChunkIndex] && !Failed && !Stopping)
+			{
+				RequestedChunk = ChunkIndex;
+				FilledEvent->Wait();
+			}
+
+			if (!FilledChunks[ChunkIndex])
+			{
+				StallCycles += FPlatformTime::Cycles() - WaitStartCycles;
+				SetError();
+
+				return;
+			}
+		}
+
+		if (WaitStartCycles != 0)
+		{
+			StallCycles += FPlatformTime::Cycles() - WaitStartCycles;
+		}
+	}
+
+	FMemory::Memcpy(Data, Buffer.GetData() + Position, Num);
+	Position = End;
+}
+
+
+int64 FVlcMediaPlayerPrecache::Tell()
+{
+	return Position;
+}
+
+
+int64 FVlcMediaPlayerPrecache::TotalSize()
+{
+	return Buffer.Num();
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+uint32 FVlcMediaPlayerPrecache::Run()
+{
+	const int64 Size = Buffer.Num();
+	int64 NextSequentialChunk = 0;
+
+	while (!Stopping)
+	{
+		const int64 ChunkIndex = GetNextChunk(NextSequentialChunk);
+
+		if (ChunkIndex == INDEX_NONE)
+		{
+			break;
+		}
+
+		const int64 Offset = ChunkIndex * ChunkSize;
+		const int64 BytesToRead = FMath::Min(ChunkSize, Size - Offset);
+
+		if (FileReader->Tell() != Offset)
+		{
+			FileReader->Seek(Offset);
+		}
+
+		FileReader->Serialize(Buffer.GetData() + Offset, BytesToRead);
+
+		if (FileReader->IsError())
+		{
+			UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Failed to precache %s at offset %lli"), *FilePath, Offset);
+
+			Failed = true;
+			break;
+		}
+
+		FilledChunks[ChunkIndex] = true;
+		FilledBytes += BytesToRead;
+		NextSequentialChunk = ChunkIndex + 1;
+
+		FilledEvent->Trigger();
+	}
+
+	if (!Failed && !Stopping)
+	{
+		LoadEndTime = FPlatformTime::Seconds();
+
+		UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Precached %s (%lli bytes) in %.1f ms"), *FilePath, Size, (LoadEndTime.load() - LoadStartTime) * 1000.0);
+	}
+
+	FileReader.Reset();
+	FilledEvent->Trigger();
+
+	return 0;
+}
+
+
+/* FVlcMediaPlayerPrecache implementation
+ *****************************************************************************/
+
+int64 FVlcMediaPlayerPrecache::GetNextChunk(int64 NextSequentialChunk)
+{
+	// a blocked read comes first
+	const int64 Requested = RequestedChunk.exchange(INDEX_NONE);
+
+	if ((Requested != INDEX_NONE) && !FilledChunks[Requested])
+	{
+		++NumRequestedChunks;
+
+		return Requested;
+	}
+
+	// otherwise continue after the last loaded chunk, then fill the chunks that were skipped
+	for (int64 Count = 0; Count < NumChunks; ++Count)
+	{
+		const int64 ChunkIndex = (NextSequentialChunk + Count) % NumChunks;
+
+		if (!FilledChunks[ChunkIndex])
+		{
+			return ChunkIndex;
+		}
+	}
+
+	return INDEX_NONE;
+}
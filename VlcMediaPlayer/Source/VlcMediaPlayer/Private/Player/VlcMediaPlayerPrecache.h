@@ -0,0 +1,137 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Serialization/Archive.h"
+#include "Templates/UniquePtr.h"
+
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+
+
+/**
+ * Loads a file into memory on a worker thread while it is being read.
+ *
+ * The buffer for the whole file is allocated up front, and the worker fills it chunk by
+ * chunk from the beginning. Filled chunks can be read right away, so that playback of a
+ * precached file starts as soon as the first chunks are resident. A read from chunks that
+ * aren't filled yet asks the worker to load those chunks next and blocks only until they
+ * are filled, i.e. when the index of an MP4 file is at its end. The worker then continues
+ * sequentially after the requested chunks, and finally fills the chunks that it skipped.
+ *
+ * The archive itself must be used by a single thread at a time.
+ */
+class FVlcMediaPlayerPrecache
+	: public FArchive
+	, public FRunnable
+{
+public:
+
+	/** Number of bytes that the worker reads at a time. */
+	static const int64 ChunkSize = 4 * 1024 * 1024;
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InFileReader The archive to load the file from.
+	 * @param InFilePath The path of the file (for logging).
+	 */
+	FVlcMediaPlayerPrecache(TUniquePtr<FArchive>&& InFileReader, const FString& InFilePath);
+
+	/** Virtual destructor. */
+	virtual ~FVlcMediaPlayerPrecache();
+
+public:
+
+	/**
+	 * Get the fraction of the file that is in memory.
+	 *
+	 * @return Progress (between 0 and 1).
+	 */
+	float GetProgress() const;
+
+	/**
+	 * Get precache statistics.
+	 *
+	 * @return Statistics string.
+	 */
+	FString GetStats() const;
+
+public:
+
+	//~ FArchive interface
+
+	virtual FString GetArchiveName() const override;
+	virtual void Seek(int64 InPos) override;
+	virtual void Serialize(void* Data, int64 Num) override;
+	virtual int64 Tell() override;
+	virtual int64 TotalSize() override;
+
+public:
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override;
+
+private:
+
+	/** Get the next chunk that the worker should load, or INDEX_NONE if all chunks are filled. */
+	int64 GetNextChunk(int64 NextSequentialChunk);
+
+private:
+
+	/** The file's contents (only the filled chunks are valid). */
+	TArray64<uint8> Buffer;
+
+	/** Whether loading the file failed. */
+	std::atomic<bool> Failed;
+
+	/** The path of the file. */
+	FString FilePath;
+
+	/** The archive to load the file from (accessed by worker thread only). */
+	TUniquePtr<FArchive> FileReader;
+
+	/** Number of bytes in the buffer that are filled. */
+	std::atomic<int64> FilledBytes;
+
+	/** Whether each chunk of the buffer is filled. */
+	TUniquePtr<std::atomic<bool>[]> FilledChunks;
+
+	/** Triggered when the worker filled another chunk, or stopped. */
+	FEvent* FilledEvent;
+
+	/** Time at which the worker finished loading the file (in seconds, or zero if still loading). */
+	std::atomic<double> LoadEndTime;
+
+	/** Time at which the worker started loading the file (in seconds). */
+	double LoadStartTime;
+
+	/** Number of chunks in the buffer. */
+	int64 NumChunks;
+
+	/** Number of chunks that the worker loaded out of order because a read requested them. */
+	std::atomic<int32> NumRequestedChunks;
+
+	/** Number of reads that waited for the worker. */
+	std::atomic<int32> NumStalls;
+
+	/** The current read position. */
+	int64 Position;
+
+	/** The chunk that a blocked read waits for (or INDEX_NONE). */
+	std::atomic<int64> RequestedChunk;
+
+	/** Total time that reads waited for the worker (in cycles). */
+	std::atomic<int64> StallCycles;
+
+	/** Whether the worker thread should exit. */
+	std::atomic<bool> Stopping;
+
+	/** The worker thread. */
+	FRunnableThread* Thread;
+};
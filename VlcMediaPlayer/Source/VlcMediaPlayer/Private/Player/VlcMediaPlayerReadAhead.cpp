@@ -0,0 +1,271 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#include "VlcMediaPlayerReadAhead.h"
+#include "VlcMediaPlayerPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+
+
+/* FVlcMediaPlayerReadAhead structors
+ *****************************************************************************/
+
+FVlcMediaPlayerReadAhead::FVlcMediaPlayerReadAhead(const TSharedRef<FArchive, ESPMode::ThreadSafe>& InArchive, FCriticalSection& InArchiveCriticalSection, int32 InNumBlocks)
+	: Archive(InArchive)
+	, ArchiveCriticalSection(InArchiveCriticalSection)
+	, FilledEvent(FPlatformProcess::GetSynchEventFromPool())
+	, MaxStallCycles(0)
+	, NumHits(0)
+	, NumMisses(0)
+	, Position(0)
+	, Size(InArchive->TotalSize())
+	, StallCycles(0)
+	, Stopping(false)
+	, Thread(nullptr)
+	, WorkEvent(FPlatformProcess::GetSynchEventFromPool())
+{
+	Blocks.SetNum(FMath::Max(InNumBlocks, 1));
+
+	for (FBlock& Block : Blocks)
+	{
+		Block.Data.SetNumUninitialized(BlockSize);
+	}
+
+	{
+		FScopeLock Lock(&CriticalSection);
+		RequestWindow(0);
+	}
+
+	Thread = FRunnableThread::Create(this, TEXT("FVlcMediaPlayerReadAhead"), 0, TPri_AboveNormal);
+}
+
+
+FVlcMediaPlayerReadAhead::~FVlcMediaPlayerReadAhead()
+{
+	if (Thread != nullptr)
+	{
+		Stopping = true;
+		WorkEvent->Trigger();
+
+		Thread->WaitForCompletion();
+		delete Thread;
+		Thread = nullptr;
+	}
+
+	FPlatformProcess::ReturnSynchEventToPool(FilledEvent);
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+}
+
+
+/* FVlcMediaPlayerReadAhead interface
+ *****************************************************************************/
+
+FString FVlcMediaPlayerReadAhead::GetStats() const
+{
+	FString StatsString;
+	{
+		StatsString += FString::Printf(TEXT("    Read-Ahead Window: %i x %i KB\n"), Blocks.Num(), (int32)(BlockSize / 1024));
+		StatsString += FString::Printf(TEXT("    Read-Ahead Hits: %i\n"), NumHits.load());
+		StatsString += FString::Printf(TEXT("    Read-Ahead Misses: %i\n"), NumMisses.load());
+		StatsString += FString::Printf(TEXT("    Stall Time: %.1f ms\n"), FPlatformTime::ToMilliseconds64(StallCycles.load()));
+		StatsString += FString::Printf(TEXT("    Max Stall Time: %.1f ms\n"), FPlatformTime::ToMilliseconds(MaxStallCycles.load()));
+	}
+
+	return StatsString;
+}
+
+
+int64 FVlcMediaPlayerReadAhead::Read(uint8* Buffer, int64 Length)
+{
+	int64 BytesRead = 0;
+	uint32 WaitCycles = 0;
+	bool Waited = false;
+
+	while ((BytesRead < Length) && (Position < Size))
+	{
+		const int64 BlockIndex = Position / BlockSize;
+		FBlock& Block = Blocks[BlockIndex % Blocks.Num()];
+
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			RequestWindow(BlockIndex);
+
+			// wait for the worker; blocks that are filled and still requested are not touched by it
+			while ((Block.FilledIndex != BlockIndex) && !Stopping)
+			{
+				const uint32 WaitStartCycles = FPlatformTime::Cycles();
+				Waited = true;
+
+				CriticalSection.Unlock();
+				FilledEvent->Wait();
+				CriticalSection.Lock();
+
+				WaitCycles += FPlatformTime::Cycles() - WaitStartCycles;
+			}
+		}
+
+		if ((Block.FilledIndex != BlockIndex) || (Block.FilledSize < 0))
+		{
+			break; // stopped or read error
+		}
+
+		const int64 BlockOffset = Position - BlockIndex * BlockSize;
+		const int64 BytesToCopy = FMath::Min(Length - BytesRead, Block.FilledSize - BlockOffset);
+
+		if (BytesToCopy <= 0)
+		{
+			break; // archive is shorter than reported
+		}
+
+		FMemory::Memcpy(Buffer + BytesRead, Block.Data.GetData() + BlockOffset, BytesToCopy);
+
+		BytesRead += BytesToCopy;
+		Position += BytesToCopy;
+	}
+
+	// update statistics
+	if (Waited)
+	{
+		++NumMisses;
+		StallCycles += WaitCycles;
+		MaxStallCycles = FMath::Max(MaxStallCycles.load(), WaitCycles);
+	}
+	else if (BytesRead > 0)
+	{
+		++NumHits;
+	}
+
+	if ((BytesRead == 0) && (Position < Size))
+	{
+		return -1;
+	}
+
+	return BytesRead;
+}
+
+
+bool FVlcMediaPlayerReadAhead::Seek(int64 Offset)
+{
+	if ((Offset < 0) || (Offset >= Size))
+	{
+		return false;
+	}
+
+	Position = Offset;
+
+	// invalidate the previous window, so that the worker starts at the new position
+	FScopeLock Lock(&CriticalSection);
+	RequestWindow(Offset / BlockSize);
+
+	return true;
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+uint32 FVlcMediaPlayerReadAhead::Run()
+{
+	while (!Stopping)
+	{
+		FBlock* Block = nullptr;
+		int64 BlockIndex = -1;
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			// fill the requested block that is needed first
+			for (FBlock& Candidate : Blocks)
+			{
+				if ((Candidate.Index >= 0) && (Candidate.Index != Candidate.FilledIndex) && ((BlockIndex < 0) || (Candidate.Index < BlockIndex)))
+				{
+					Block = &Candidate;
+					BlockIndex = Candidate.Index;
+				}
+			}
+
+			if (Block != nullptr)
+			{
+				Block->FilledIndex = -1; // the reader must not use the buffer while it is being written
+			}
+		}
+
+		if (Block == nullptr)
+		{
+			WorkEvent->Wait();
+			continue;
+		}
+
+		const int64 Offset = BlockIndex * BlockSize;
+		const int64 BytesToRead = FMath::Min(BlockSize, Size - Offset);
+		bool Failed = false;
+		{
+			FScopeLock ArchiveLock(&ArchiveCriticalSection);
+
+			// other readers may have moved the archive
+			if (Archive->Tell() != Offset)
+			{
+				Archive->Seek(Offset);
+			}
+
+			Archive->Serialize(Block->Data.GetData(), BytesToRead);
+			Failed = Archive->IsError();
+
+			if (Failed)
+			{
+				Archive->ClearError();
+			}
+		}
+
+		if (Failed)
+		{
+			UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Read-ahead %p: Failed to read %lli bytes at offset %lli"), this, BytesToRead, Offset);
+		}
+
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			Block->FilledIndex = BlockIndex;
+			Block->FilledSize = Failed ? -1 : BytesToRead;
+		}
+
+		FilledEvent->Trigger();
+	}
+
+	FilledEvent->Trigger();
+
+	return 0;
+}
+
+
+/* FVlcMediaPlayerReadAhead implementation
+ *****************************************************************************/
+
+void FVlcMediaPlayerReadAhead::RequestWindow(int64 FirstBlock)
+{
+	bool Requested = false;
+
+	for (int64 BlockIndex = FirstBlock; BlockIndex < FirstBlock + Blocks.Num(); ++BlockIndex)
+	{
+		if (BlockIndex * BlockSize >= Size)
+		{
+			break;
+		}
+
+		FBlock& Block = Blocks[BlockIndex % Blocks.Num()];
+
+		if (Block.Index != BlockIndex)
+		{
+			Block.Index = BlockIndex;
+			Requested = true;
+		}
+	}
+
+	if (Requested)
+	{
+		WorkEvent->Trigger();
+	}
+}
@@ -0,0 +1,160 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include "Serialization/Archive.h"
+#include "Templates/SharedPointer.h"
+
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+
+
+/**
+ * Reads blocks of an archive ahead of VLC's read position on a worker thread.
+ *
+ * VLC reads media data synchronously on its input thread, so that any storage latency
+ * stalls demuxing. The read-ahead keeps a window of blocks following the read position
+ * in flight, and VLC's reads are served from blocks that were already filled. Seeking
+ * moves the window; blocks outside of it are reused for the new position.
+ *
+ * The worker accesses the archive under the specified critical section, so that other
+ * readers can share it. Read and Seek must be called on a single thread at a time.
+ */
+class FVlcMediaPlayerReadAhead
+	: public FRunnable
+{
+public:
+
+	/** Size of the blocks that are read ahead (in bytes). */
+	static const int64 BlockSize = 1024 * 1024;
+
+	/**
+	 * Create and initialize a new instance.
+	 *
+	 * @param InArchive The archive to read from.
+	 * @param InArchiveCriticalSection Critical section that guards access to the archive.
+	 * @param InNumBlocks Number of blocks to keep in flight.
+	 */
+	FVlcMediaPlayerReadAhead(const TSharedRef<FArchive, ESPMode::ThreadSafe>& InArchive, FCriticalSection& InArchiveCriticalSection, int32 InNumBlocks);
+
+	/** Virtual destructor. */
+	virtual ~FVlcMediaPlayerReadAhead();
+
+public:
+
+	/**
+	 * Get read-ahead statistics.
+	 *
+	 * @return Statistics string.
+	 */
+	FString GetStats() const;
+
+	/**
+	 * Get the size of the archive.
+	 *
+	 * @return Size (in bytes).
+	 */
+	int64 GetSize() const
+	{
+		return Size;
+	}
+
+	/**
+	 * Read data at the current position, waiting for blocks that are not filled yet.
+	 *
+	 * @param Buffer The buffer to read into.
+	 * @param Length Maximum number of bytes to read.
+	 * @return Number of bytes read (zero at the end of the archive), or -1 on error.
+	 */
+	int64 Read(uint8* Buffer, int64 Length);
+
+	/**
+	 * Move the read position, and start reading ahead from there.
+	 *
+	 * @param Offset The new read position.
+	 * @return true on success, false if the position is beyond the end of the archive.
+	 */
+	bool Seek(int64 Offset);
+
+public:
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override;
+
+protected:
+
+	/**
+	 * Request the blocks of the window that starts at the specified block.
+	 *
+	 * The critical section must be locked.
+	 *
+	 * @param FirstBlock Index of the first block in the window.
+	 */
+	void RequestWindow(int64 FirstBlock);
+
+private:
+
+	/** A buffer that holds one block of the archive. */
+	struct FBlock
+	{
+		/** The block's data. */
+		TArray<uint8> Data;
+
+		/** Index of the block whose data is in the buffer (-1 if none). */
+		int64 FilledIndex = -1;
+
+		/** Number of valid bytes in the buffer (-1 if reading failed). */
+		int64 FilledSize = 0;
+
+		/** Index of the block that the buffer should hold (-1 if none). */
+		int64 Index = -1;
+	};
+
+	/** The archive to read from. */
+	TSharedRef<FArchive, ESPMode::ThreadSafe> Archive;
+
+	/** Critical section that guards access to the archive. */
+	FCriticalSection& ArchiveCriticalSection;
+
+	/** Block buffers, each holding the blocks whose index modulo the number of buffers matches. */
+	TArray<FBlock> Blocks;
+
+	/** Critical section for synchronizing access to the blocks. */
+	mutable FCriticalSection CriticalSection;
+
+	/** Triggered when the worker filled a block. */
+	FEvent* FilledEvent;
+
+	/** Longest time that a read waited for a block (in cycles). */
+	std::atomic<uint32> MaxStallCycles;
+
+	/** Number of reads that were served from blocks filled ahead of time. */
+	std::atomic<int32> NumHits;
+
+	/** Number of reads that had to wait for a block. */
+	std::atomic<int32> NumMisses;
+
+	/** The current read position (accessed by reading thread only). */
+	int64 Position;
+
+	/** Size of the archive. */
+	int64 Size;
+
+	/** Total time that reads waited for blocks (in cycles). */
+	std::atomic<int64> StallCycles;
+
+	/** Whether the worker thread should exit. */
+	std::atomic<bool> Stopping;
+
+	/** The worker thread. */
+	FRunnableThread* Thread;
+
+	/** Triggered when blocks were requested or the worker is stopping. */
+	FEvent* WorkEvent;
+};
@@ -0,0 +1,194 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#include "VlcMediaPlayerReaper.h"
+#include "VlcMediaPlayerPrivate.h"
+
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+
+#include "VlcMediaPlayerCallbacks.h"
+#include "VlcMediaPlayerSource.h"
+
+
+/* FVlcMediaPlayerReaper structors
+ *****************************************************************************/
+
+FVlcMediaPlayerReaper::FVlcMediaPlayerReaper()
+	: MaxStopTime(0.0)
+	, MaxQueueLength(0)
+	, NumReaped(0)
+	, NumSynchronous(0)
+	, Stopped(false)
+	, Thread(nullptr)
+	, TotalStopTime(0.0)
+	, WorkEvent(nullptr)
+{
+	Pending.Reserve(MaxPending);
+}
+
+
+FVlcMediaPlayerReaper::~FVlcMediaPlayerReaper()
+{
+	Shutdown();
+}
+
+
+/* FVlcMediaPlayerReaper interface
+ *****************************************************************************/
+
+FVlcMediaPlayerReaper& FVlcMediaPlayerReaper::Get()
+{
+	static FVlcMediaPlayerReaper Reaper;
+	return Reaper;
+}
+
+
+FString FVlcMediaPlayerReaper::GetStats() const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FString StatsString;
+	{
+		StatsString += TEXT("Reaper\n");
+		StatsString += FString::Printf(TEXT("    Pending: %i\n"), Pending.Num());
+		StatsString += FString::Printf(TEXT("    Max Pending: %i\n"), MaxQueueLength);
+		StatsString += FString::Printf(TEXT("    Stopped Players: %i\n"), NumReaped);
+		StatsString += FString::Printf(TEXT("    Stopped On Caller: %i\n"), NumSynchronous);
+		StatsString += FString::Printf(TEXT("    Average Stop Time: %.1f ms\n"), (NumReaped > 0) ? TotalStopTime * 1000.0 / NumReaped : 0.0);
+		StatsString += FString::Printf(TEXT("    Max Stop Time: %.1f ms\n"), MaxStopTime * 1000.0);
+		StatsString += TEXT("\n");
+	}
+
+	return StatsString;
+}
+
+
+void FVlcMediaPlayerReaper::Reap(libvlc_media_player_t* Player, const TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe>& Source, const TSharedPtr<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe>& Callbacks)
+{
+	FItem Item{ Callbacks, Player, Source };
+
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (!Stopped && (Pending.Num() < MaxPending))
+		{
+			if (Thread == nullptr)
+			{
+				WorkEvent = FPlatformProcess::GetSynchEventFromPool();
+				Thread = FRunnableThread::Create(this, TEXT("FVlcMediaPlayerReaper"), 0, TPri_BelowNormal);
+			}
+
+			if (Thread != nullptr)
+			{
+				Pending.Add(MoveTemp(Item));
+				MaxQueueLength = FMath::Max(MaxQueueLength, Pending.Num());
+				WorkEvent->Trigger();
+
+				return;
+			}
+		}
+
+		++NumSynchronous;
+	}
+
+	UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Reaper: Stopping player %p on the calling thread"), Player);
+
+	ReapItem(Item);
+}
+
+
+void FVlcMediaPlayerReaper::Shutdown()
+{
+	FRunnableThread* ReaperThread = nullptr;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		Stopped = true;
+		ReaperThread = Thread;
+		Thread = nullptr;
+	}
+
+	if (ReaperThread != nullptr)
+	{
+		WorkEvent->Trigger();
+		ReaperThread->WaitForCompletion();
+		delete ReaperThread;
+
+		FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+		WorkEvent = nullptr;
+
+		UE_LOG(LogVlcMediaPlayer, Log, TEXT("Reaper: Stopped %i players (%i on the calling thread, max. %.1f ms)"), NumReaped, NumSynchronous, MaxStopTime * 1000.0);
+	}
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+uint32 FVlcMediaPlayerReaper::Run()
+{
+	while (true)
+	{
+		WorkEvent->Wait();
+
+		bool ShouldExit = false;
+		TArray<FItem> Items;
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			Swap(Items, Pending);
+			Pending.Reserve(MaxPending);
+			ShouldExit = Stopped;
+		}
+
+		for (FItem& Item : Items)
+		{
+			ReapItem(Item);
+		}
+
+		// players queued before shutdown are always drained
+		if (ShouldExit)
+		{
+			break;
+		}
+	}
+
+	return 0;
+}
+
+
+/* FVlcMediaPlayerReaper implementation
+ *****************************************************************************/
+
+void FVlcMediaPlayerReaper::ReapItem(FItem& Item)
+{
+	const double StartTime = FPlatformTime::Seconds();
+
+	// callbacks may still be invoked until the player stopped
+	libvlc_media_player_stop(Item.Player);
+
+	if (Item.Callbacks.IsValid())
+	{
+		Item.Callbacks->Shutdown();
+	}
+
+	libvlc_media_player_release(Item.Player);
+
+	if (Item.Source.IsValid())
+	{
+		Item.Source->Close();
+	}
+
+	const double StopTime = FPlatformTime::Seconds() - StartTime;
+
+	UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Reaper: Stopped player %p in %.1f ms"), Item.Player, StopTime * 1000.0);
+
+	FScopeLock Lock(&CriticalSection);
+
+	MaxStopTime = FMath::Max(MaxStopTime, StopTime);
+	TotalStopTime += StopTime;
+	++NumReaped;
+}
@@ -0,0 +1,137 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/Runnable.h"
+#include "Templates/SharedPointer.h"
+
+#include "VlcWrapper.h"
+
+class FEvent;
+class FRunnableThread;
+class FVlcMediaPlayerCallbacks;
+class FVlcMediaPlayerSource;
+
+
+/**
+ * Stops and releases VLC players on a background thread.
+ *
+ * Stopping a player joins VLC's input, decoder and output threads, which can take a
+ * long time for network streams. Closed players are therefore handed to the reaper
+ * together with the objects that VLC's callbacks still refer to, so that those stay
+ * alive until the player has stopped.
+ *
+ * The number of pending players is bounded. If the queue is full, or the reaper was
+ * shut down, players are stopped on the calling thread instead.
+ */
+class FVlcMediaPlayerReaper
+	: public FRunnable
+{
+public:
+
+	/** Maximum number of players waiting to be stopped. */
+	static const int32 MaxPending = 16;
+
+	/**
+	 * Get the reaper singleton.
+	 *
+	 * @return The reaper.
+	 */
+	static FVlcMediaPlayerReaper& Get();
+
+public:
+
+	/**
+	 * Get reaper statistics.
+	 *
+	 * @return Statistics string.
+	 */
+	FString GetStats() const;
+
+	/**
+	 * Stop and release a player.
+	 *
+	 * The player's event handlers must have been detached.
+	 *
+	 * @param Player The player to stop and release.
+	 * @param Source The player's media source.
+	 * @param Callbacks The player's audio and video callbacks.
+	 */
+	void Reap(libvlc_media_player_t* Player, const TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe>& Source, const TSharedPtr<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe>& Callbacks);
+
+	/**
+	 * Stop all pending players and shut down the reaper thread.
+	 *
+	 * This method blocks until all players were released. It must be called before
+	 * the LibVLC instance is released.
+	 */
+	void Shutdown();
+
+public:
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override;
+
+protected:
+
+	/** A player waiting to be stopped. */
+	struct FItem
+	{
+		/** The player's audio and video callbacks. */
+		TSharedPtr<FVlcMediaPlayerCallbacks, ESPMode::ThreadSafe> Callbacks;
+
+		/** The player to stop. */
+		libvlc_media_player_t* Player;
+
+		/** The player's media source. */
+		TSharedPtr<FVlcMediaPlayerSource, ESPMode::ThreadSafe> Source;
+	};
+
+	/** Hidden constructor (use Get). */
+	FVlcMediaPlayerReaper();
+
+	/** Hidden destructor. */
+	virtual ~FVlcMediaPlayerReaper();
+
+	/**
+	 * Stop and release a player on the calling thread.
+	 *
+	 * @param Item The player to stop.
+	 */
+	void ReapItem(FItem& Item);
+
+private:
+
+	/** Critical section for synchronizing access to the queue and statistics. */
+	mutable FCriticalSection CriticalSection;
+
+	/** Longest time that stopping a player took. */
+	double MaxStopTime;
+
+	/** Largest number of players that were waiting at the same time. */
+	int32 MaxQueueLength;
+
+	/** Number of players that were stopped. */
+	int32 NumReaped;
+
+	/** Number of players that were stopped on the calling thread because the queue was full. */
+	int32 NumSynchronous;
+
+	/** Players waiting to be stopped. */
+	TArray<FItem> Pending;
+
+	/** Whether the reaper was shut down. */
+	bool Stopped;
+
+	/** The reaper thread (created on first use). */
+	FRunnableThread* Thread;
+
+	/** Total time spent stopping players. */
+	double TotalStopTime;
+
+	/** Triggered when players were queued or the reaper is shutting down. */
+	FEvent* WorkEvent;
+};
@@ -0,0 +1,92 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "MediaSamples.h"
+
+
+/**
+ * Media sample queues that notify VLC's audio thread when the queued audio was consumed.
+ *
+ * VLC waits for the audio output to drain before it ends playback, so the drain
+ * callback blocks until the consumers fetched all queued audio samples.
+ */
+class FVlcMediaPlayerSamples
+	: public FMediaSamples
+{
+public:
+
+	/** Default constructor. */
+	FVlcMediaPlayerSamples()
+		: AudioConsumedEvent(FPlatformProcess::GetSynchEventFromPool(false))
+	{ }
+
+	/** Virtual destructor. */
+	virtual ~FVlcMediaPlayerSamples()
+	{
+		FPlatformProcess::ReturnSynchEventToPool(AudioConsumedEvent);
+	}
+
+public:
+
+	/** Wake up a thread that is waiting for the audio to be consumed, i.e. when the wait was aborted. */
+	void NotifyAudioConsumed()
+	{
+		AudioConsumedEvent->Trigger();
+	}
+
+	/**
+	 * Wait until the consumers fetched all queued audio samples.
+	 *
+	 * The wait may also end early if it was interrupted, so callers must check the queue again.
+	 *
+	 * @param WaitTime Longest time to wait (in milliseconds).
+	 * @return true if the wait was ended by a notification, false if it timed out.
+	 */
+	bool WaitForAudioConsumed(uint32 WaitTime)
+	{
+		return AudioConsumedEvent->Wait(WaitTime);
+	}
+
+public:
+
+	//~ IMediaSamples interface
+
+	virtual bool FetchAudio(TRange<FTimespan> TimeRange, TSharedPtr<IMediaAudioSample, ESPMode::ThreadSafe>& OutSample) override
+	{
+		const bool Fetched = FMediaSamples::FetchAudio(TimeRange, OutSample);
+
+		if (Fetched && (NumAudio() == 0))
+		{
+			AudioConsumedEvent->Trigger();
+		}
+
+		return Fetched;
+	}
+
+	virtual bool FetchAudio(TRange<FMediaTimeStamp> TimeRange, TSharedPtr<IMediaAudioSample, ESPMode::ThreadSafe>& OutSample) override
+	{
+		const bool Fetched = FMediaSamples::FetchAudio(TimeRange, OutSample);
+
+		if (Fetched && (NumAudio() == 0))
+		{
+			AudioConsumedEvent->Trigger();
+		}
+
+		return Fetched;
+	}
+
+	virtual void FlushSamples() override
+	{
+		FMediaSamples::FlushSamples();
+		AudioConsumedEvent->Trigger();
+	}
+
+private:
+
+	/** Triggered when the audio sample queue runs empty (auto-reset). */
+	FEvent* AudioConsumedEvent;
+};
@@ -3,18 +3,82 @@
 #include "VlcMediaPlayerSource.h"
 #include "VlcMediaPlayerPrivate.h"
 
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "HAL/PlatformTime.h"
+#include "IMediaOptions.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/Class.h"
+
+#include "VlcMediaPlayerCachedArchive.h"
+#include "VlcMediaPlayerChunkCache.h"
+#include "VlcMediaPlayerPrecache.h"
+#include "VlcMediaPlayerReadAhead.h"
+
+#if PLATFORM_WINDOWS
+	#include "Windows/WindowsHWrapper.h"
+#elif PLATFORM_UNIX || PLATFORM_MAC
+	#include <sys/mman.h>
+#endif
+
+
+/* Local helpers
+*****************************************************************************/
+
+namespace VlcMediaPlayerSource
+{
+	/** Largest amount of mapped data ahead of the read position that the OS is asked to page in. */
+	const uint64 MappedReadAhead = 8 * 1024 * 1024;
 
+	/** Tell the OS that a mapped range will be read sequentially. */
+	void AdviseSequential(const uint8* Ptr, SIZE_T Size)
+	{
+#if PLATFORM_UNIX || PLATFORM_MAC
+		madvise((void*)Ptr, Size, MADV_SEQUENTIAL);
+#endif
+	}
+
+	/** Ask the OS to page in a mapped range ahead of time. */
+	void AdviseWillNeed(const uint8* Ptr, SIZE_T Size)
+	{
+#if PLATFORM_WINDOWS
+		WIN32_MEMORY_RANGE_ENTRY Range;
+		Range.VirtualAddress = (PVOID)Ptr;
+		Range.NumberOfBytes = Size;
+
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &Range, 0);
+#elif PLATFORM_UNIX || PLATFORM_MAC
+		// madvise requires a page aligned address
+		const UPTRINT PageSize = (UPTRINT)FPlatformMemory::GetConstants().PageSize;
+		const UPTRINT Start = (UPTRINT)Ptr & ~(PageSize - 1);
+
+		madvise((void*)Start, Size + ((UPTRINT)Ptr - Start), MADV_WILLNEED);
+#endif
+	}
+}
 
 
 /* FVlcMediaReader structors
 *****************************************************************************/
 
-FVlcMediaPlayerSource::FVlcMediaPlayerSource(libvlc_instance_t* InVlcInstance)
-	: Media(nullptr)
+FVlcMediaPlayerSource::FVlcMediaPlayerSource(libvlc_instance_t* InVlcInstance, const TArray<FString>& InInputOptions)
+	: BytesRead(0)
+	, InputOptions(InInputOptions)
+	, Media(nullptr)
+	, NumOpens(0)
+	, NumReads(0)
+	, ReadAheadInUse(false)
+	, ReadCycles(0)
 	, VlcInstance(InVlcInstance)
 { }
 
 
+FVlcMediaPlayerSource::~FVlcMediaPlayerSource()
+{
+	Close();
+}
+
+
 /* FVlcMediaReader interface
 *****************************************************************************/
 
@@ -36,16 +100,145 @@ FTimespan FVlcMediaPlayerSource::GetDuration() const
 }
 
 
+TArray<FString> FVlcMediaPlayerSource::GetInputOptions(const IMediaOptions* Options)
+{
+	TArray<FString> InputOptions;
+
+	if (Options == nullptr)
+	{
+		return InputOptions;
+	}
+
+	// caching
+	const TCHAR* CachingOptions[][2] = {
+		{ TEXT("DiscCaching"), TEXT("disc-caching") },
+		{ TEXT("FileCaching"), TEXT("file-caching") },
+		{ TEXT("LiveCaching"), TEXT("live-caching") },
+		{ TEXT("NetworkCaching"), TEXT("network-caching") },
+	};
+
+	for (const auto& CachingOption : CachingOptions)
+	{
+		if (Options->HasMediaOption(CachingOption[0]))
+		{
+			const int64 Caching = FMath::Max<int64>(0, Options->GetMediaOption(CachingOption[0], (int64)0));
+			InputOptions.Add(FString::Printf(TEXT(":%s=%lli"), CachingOption[1], Caching));
+		}
+	}
+
+	// decoding
+	if (Options->HasMediaOption(TEXT("DecoderThreads")))
+	{
+		const int64 Threads = FMath::Max<int64>(0, Options->GetMediaOption(TEXT("DecoderThreads"), (int64)0));
+		InputOptions.Add(FString::Printf(TEXT(":avcodec-threads=%lli"), Threads));
+	}
+
+	if (Options->HasMediaOption(TEXT("FastDecoding")))
+	{
+		InputOptions.Add(Options->GetMediaOption(TEXT("FastDecoding"), false) ? TEXT(":avcodec-fast") : TEXT(":no-avcodec-fast"));
+	}
+
+	if (Options->HasMediaOption(TEXT("SkipFrames")))
+	{
+		const int64 SkipFrames = FMath::Clamp<int64>(Options->GetMediaOption(TEXT("SkipFrames"), (int64)0), -1, 4);
+		InputOptions.Add(FString::Printf(TEXT(":avcodec-skip-frame=%lli"), SkipFrames));
+	}
+
+	if (Options->HasMediaOption(TEXT("SkipLoopFilter")))
+	{
+		const int64 SkipLoopFilter = FMath::Clamp<int64>(Options->GetMediaOption(TEXT("SkipLoopFilter"), (int64)0), 0, 4);
+		InputOptions.Add(FString::Printf(TEXT(":avcodec-skiploopfilter=%lli"), SkipLoopFilter));
+	}
+
+	// demuxing
+	const FString Demux = Options->GetMediaOption(TEXT("Demux"), FString());
+
+	if (!Demux.IsEmpty())
+	{
+		InputOptions.Add(FString::Printf(TEXT(":demux=%s"), *Demux));
+	}
+
+	const FString DemuxFilter = Options->GetMediaOption(TEXT("DemuxFilter"), FString());
+
+	if (!DemuxFilter.IsEmpty())
+	{
+		InputOptions.Add(FString::Printf(TEXT(":demux-filter=%s"), *DemuxFilter));
+	}
+
+	return InputOptions;
+}
+
+
+float FVlcMediaPlayerSource::GetPrecacheProgress() const
+{
+	return Precache.IsValid() ? Precache->GetProgress() : 1.0f;
+}
+
+
+FString FVlcMediaPlayerSource::GetStats() const
+{
+	const TCHAR* Mode = MappedRegion.IsValid() ? TEXT("Mapped File") : (Precache.IsValid() ? TEXT("Precached File") : (Data.IsValid() ? TEXT("Archive") : TEXT("URL")));
+	const double ReadSeconds = FPlatformTime::ToSeconds64(ReadCycles.load());
+	const double MegaBytesRead = BytesRead.load() / (1024.0 * 1024.0);
+
+	FString StatsString;
+	{
+		StatsString += TEXT("Source\n");
+		StatsString += FString::Printf(TEXT("    Mode: %s\n"), Mode);
+		StatsString += FString::Printf(TEXT("    Opens: %i\n"), NumOpens.load());
+		StatsString += FString::Printf(TEXT("    Reads: %i\n"), NumReads.load());
+		StatsString += FString::Printf(TEXT("    Bytes Read: %.1f MB\n"), MegaBytesRead);
+
+		if (ReadSeconds > 0.0)
+		{
+			StatsString += FString::Printf(TEXT("    Read Throughput: %.1f MB/s\n"), MegaBytesRead / ReadSeconds);
+		}
+
+		if (Precache.IsValid())
+		{
+			StatsString += Precache->GetStats();
+		}
+
+		if (ReadAhead.IsValid())
+		{
+			StatsString += ReadAhead->GetStats();
+		}
+		StatsString += TEXT("\n");
+	}
+
+	return StatsString;
+}
+
+
 libvlc_media_t* FVlcMediaPlayerSource::OpenArchive(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl)
 {
 	check(Media == nullptr);
 
 	if (Archive->TotalSize() > 0)
 	{
-		Data = Archive;
+		FVlcMediaPlayerChunkCache& ChunkCache = FVlcMediaPlayerChunkCache::Get();
+
+		// share chunks with other players that read the same media; precached files are already in memory
+		if (ChunkCache.IsEnabled() && !Precache.IsValid())
+		{
+			Data = MakeShared<FVlcMediaPlayerCachedArchive, ESPMode::ThreadSafe>(Archive, ChunkCache.RegisterSource(OriginalUrl, Archive->TotalSize()));
+		}
+		else
+		{
+			Data = Archive;
+		}
+
+		const int32 ReadAheadBlocks = GetDefault<UVlcMediaPlayerSettings>()->ReadAheadBlocks;
+
+		// precached files are already read ahead into memory
+		if ((ReadAheadBlocks > 0) && !Precache.IsValid())
+		{
+			ReadAhead = MakeUnique<FVlcMediaPlayerReadAhead>(Data.ToSharedRef(), ArchiveCriticalSection, ReadAheadBlocks);
+		}
+
 		Media = libvlc_media_new_callbacks(
 			VlcInstance,
-			nullptr,
+			&FVlcMediaPlayerSource::HandleMediaOpen,
 			&FVlcMediaPlayerSource::HandleMediaRead,
 			&FVlcMediaPlayerSource::HandleMediaSeek,
 			&FVlcMediaPlayerSource::HandleMediaClose,
@@ -55,10 +248,12 @@ libvlc_media_t* FVlcMediaPlayerSource::OpenArchive(const TSharedRef<FArchive, ES
 		if (Media == nullptr)
 		{
 			UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Failed to open media from archive: %s (%s)"), *OriginalUrl, ANSI_TO_TCHAR(libvlc_errmsg()));
+			ReadAhead.Reset();
 			Data.Reset();
 		}
 		else
 		{
+			AddInputOptions();
 			CurrentUrl = OriginalUrl;
 		}
 	}
@@ -67,6 +262,71 @@ libvlc_media_t* FVlcMediaPlayerSource::OpenArchive(const TSharedRef<FArchive, ES
 }
 
 
+libvlc_media_t* FVlcMediaPlayerSource::OpenMappedFile(const FString& FilePath, const FString& OriginalUrl)
+{
+	check(Media == nullptr);
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+
+	if (!MappedFile.IsValid() || (MappedFile->GetFileSize() <= 0))
+	{
+		UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Cannot memory map media file %s"), *FilePath);
+		MappedFile.Reset();
+
+		return nullptr;
+	}
+
+	MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+
+	if (!MappedRegion.IsValid())
+	{
+		UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Failed to map media file %s"), *FilePath);
+		MappedFile.Reset();
+
+		return nullptr;
+	}
+
+	VlcMediaPlayerSource::AdviseSequential(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+
+	Media = libvlc_media_new_callbacks(
+		VlcInstance,
+		&FVlcMediaPlayerSource::HandleMediaOpen,
+		&FVlcMediaPlayerSource::HandleMappedMediaRead,
+		&FVlcMediaPlayerSource::HandleMappedMediaSeek,
+		&FVlcMediaPlayerSource::HandleMediaClose,
+		this
+	);
+
+	if (Media == nullptr)
+	{
+		UE_LOG(LogVlcMediaPlayer, Warning, TEXT("Failed to open media from mapped file: %s (%s)"), *OriginalUrl, ANSI_TO_TCHAR(libvlc_errmsg()));
+
+		MappedRegion.Reset();
+		MappedFile.Reset();
+	}
+	else
+	{
+		AddInputOptions();
+		CurrentUrl = OriginalUrl;
+	}
+
+	return Media;
+}
+
+
+libvlc_media_t* FVlcMediaPlayerSource::OpenPrecachedFile(const TSharedRef<FVlcMediaPlayerPrecache, ESPMode::ThreadSafe>& InPrecache, const FString& OriginalUrl)
+{
+	Precache = InPrecache;
+
+	if (OpenArchive(InPrecache, OriginalUrl) == nullptr)
+	{
+		Precache.Reset();
+	}
+
+	return Media;
+}
+
+
 libvlc_media_t* FVlcMediaPlayerSource::OpenUrl(const FString& Url)
 {
 	check(Media == nullptr);
@@ -79,6 +339,7 @@ libvlc_media_t* FVlcMediaPlayerSource::OpenUrl(const FString& Url)
 	}
 	else
 	{
+		AddInputOptions();
 		CurrentUrl = Url;
 	}
 
@@ -94,30 +355,47 @@ void FVlcMediaPlayerSource::Close()
 		Media = nullptr;
 	}
 
+	// stops the read-ahead thread before the archive is released
+	ReadAhead.Reset();
 	Data.Reset();
+	Precache.Reset();
 	CurrentUrl.Reset();
+
+	// the region must be unmapped before the file is closed
+	MappedRegion.Reset();
+	MappedFile.Reset();
 }
 
 
-/* FVlcMediaReader static functions
+/* FVlcMediaReader implementation
 *****************************************************************************/
 
-int FVlcMediaPlayerSource::HandleMediaOpen(void* Opaque, void** OutData, uint64* OutSize)
+void FVlcMediaPlayerSource::AddInputOptions()
 {
-	auto Reader = (FVlcMediaPlayerSource*)Opaque;
+	for (const FString& InputOption : InputOptions)
+	{
+		libvlc_media_add_option(Media, TCHAR_TO_ANSI(*InputOption));
+	}
 
-	if ((Reader == nullptr) || !Reader->Data.IsValid())
+	if (InputOptions.Num() > 0)
 	{
-		return 0;
+		UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Media %p: Added input options %s"), Media, *FString::Join(InputOptions, TEXT(" ")));
 	}
+}
 
-	*OutSize = Reader->Data->TotalSize();
 
-	return 0;
+void FVlcMediaPlayerSource::TrackRead(SIZE_T Bytes, uint32 Cycles)
+{
+	BytesRead += Bytes;
+	ReadCycles += Cycles;
+	++NumReads;
 }
 
 
-SSIZE_T FVlcMediaPlayerSource::HandleMediaRead(void* Opaque, unsigned char* Buffer, SIZE_T Length)
+/* FVlcMediaReader static functions
+*****************************************************************************/
+
+int FVlcMediaPlayerSource::HandleMediaOpen(void* Opaque, void** OutData, uint64* OutSize)
 {
 	auto Reader = (FVlcMediaPlayerSource*)Opaque;
 
@@ -126,53 +404,115 @@ SSIZE_T FVlcMediaPlayerSource::HandleMediaRead(void* Opaque, unsigned char* Buff
 		return -1;
 	}
 
-	TSharedPtr<FArchive, ESPMode::ThreadSafe> Data = Reader->Data;
+	// each open gets its own read position, so that VLC can open the media more than once
+	FReadContext* Context = new FReadContext;
+	Context->Source = Reader;
+
+	if (Reader->MappedRegion.IsValid())
+	{
+		*OutSize = (uint64)Reader->MappedRegion->GetMappedSize();
+	}
+	else if (Reader->Data.IsValid())
+	{
+		*OutSize = (uint64)Reader->Data->TotalSize();
+
+		// the read-ahead follows a single reader; concurrent opens read the archive directly
+		bool ReadAheadInUse = false;
 
-	if (!Reader->Data.IsValid())
+		if (Reader->ReadAhead.IsValid() && Reader->ReadAheadInUse.compare_exchange_strong(ReadAheadInUse, true))
+		{
+			Reader->ReadAhead->Seek(0);
+			Context->UsesReadAhead = true;
+		}
+	}
+	else
 	{
+		delete Context;
 		return -1;
 	}
 
-	SIZE_T DataSize = (SIZE_T)Data->TotalSize();
-	SIZE_T BytesToRead = FMath::Min(Length, DataSize);
-	SIZE_T DataPosition = Reader->Data->Tell();
+	++Reader->NumOpens;
+	*OutData = Context;
+
+	return 0;
+}
+
 
-	if ((DataSize - BytesToRead) < DataPosition)
+SSIZE_T FVlcMediaPlayerSource::HandleMediaRead(void* Opaque, unsigned char* Buffer, SIZE_T Length)
+{
+	auto Context = (FReadContext*)Opaque;
+
+	if (Context == nullptr)
 	{
-		BytesToRead = DataSize - DataPosition;
+		return -1;
 	}
 
-	if (BytesToRead > 0)
+	FVlcMediaPlayerSource* Reader = Context->Source;
+	const uint32 StartCycles = FPlatformTime::Cycles();
+
+	if (Context->UsesReadAhead)
 	{
-		Data->Serialize(Buffer, BytesToRead);
+		const int64 BytesRead = Reader->ReadAhead->Read(Buffer, (int64)Length);
+
+		if (BytesRead > 0)
+		{
+			Reader->TrackRead((SIZE_T)BytesRead, FPlatformTime::Cycles() - StartCycles);
+		}
+
+		return (SSIZE_T)BytesRead;
 	}
 
+	FArchive& Data = *Reader->Data;
+	SIZE_T BytesToRead = 0;
+	{
+		FScopeLock Lock(&Reader->ArchiveCriticalSection);
+
+		const uint64 DataSize = (uint64)Data.TotalSize();
+
+		if (Context->Position >= DataSize)
+		{
+			return 0;
+		}
+
+		BytesToRead = (SIZE_T)FMath::Min<uint64>(Length, DataSize - Context->Position);
+
+		if ((uint64)Data.Tell() != Context->Position)
+		{
+			Data.Seek((int64)Context->Position);
+		}
+
+		Data.Serialize(Buffer, BytesToRead);
+	}
+
+	Context->Position += BytesToRead;
+	Reader->TrackRead(BytesToRead, FPlatformTime::Cycles() - StartCycles);
+
 	return (SSIZE_T)BytesToRead;
 }
 
 
 int FVlcMediaPlayerSource::HandleMediaSeek(void* Opaque, uint64 Offset)
 {
-	auto Reader = (FVlcMediaPlayerSource*)Opaque;
+	auto Context = (FReadContext*)Opaque;
 
-	if (Reader == nullptr)
+	if (Context == nullptr)
 	{
 		return -1;
 	}
 
-	TSharedPtr<FArchive, ESPMode::ThreadSafe> Data = Reader->Data;
+	FVlcMediaPlayerSource* Reader = Context->Source;
 
-	if (!Reader->Data.IsValid())
+	if (Context->UsesReadAhead)
 	{
-		return -1;
+		return Reader->ReadAhead->Seek((int64)Offset) ? 0 : -1;
 	}
 
-	if ((uint64)Data->TotalSize() <= Offset)
+	if ((uint64)Reader->Data->TotalSize() <= Offset)
 	{
 		return -1;
 	}
 
-	Reader->Data->Seek(Offset);
+	Context->Position = Offset; // the archive is moved on the next read
 
 	return 0;
 }
@@ -180,10 +520,87 @@ int FVlcMediaPlayerSource::HandleMediaSeek(void* Opaque, uint64 Offset)
 
 void FVlcMediaPlayerSource::HandleMediaClose(void* Opaque)
 {
-	auto Reader = (FVlcMediaPlayerSource*)Opaque;
+	auto Context = (FReadContext*)Opaque;
+
+	if (Context == nullptr)
+	{
+		return;
+	}
 
-	if (Reader != nullptr)
+	if (Context->UsesReadAhead)
 	{
-		Reader->Data->Seek(0);
+		Context->Source->ReadAheadInUse = false;
 	}
+
+	delete Context;
+}
+
+
+SSIZE_T FVlcMediaPlayerSource::HandleMappedMediaRead(void* Opaque, unsigned char* Buffer, SIZE_T Length)
+{
+	auto Context = (FReadContext*)Opaque;
+
+	if (Context == nullptr)
+	{
+		return -1;
+	}
+
+	FVlcMediaPlayerSource* Reader = Context->Source;
+	const uint64 MappedSize = (uint64)Reader->MappedRegion->GetMappedSize();
+	const uint64 Position = Context->Position;
+
+	if (Position >= MappedSize)
+	{
+		return 0;
+	}
+
+	const uint32 StartCycles = FPlatformTime::Cycles();
+	const uint8* MappedPtr = Reader->MappedRegion->GetMappedPtr();
+	const SIZE_T BytesToRead = (SIZE_T)FMath::Min<uint64>(Length, MappedSize - Position);
+
+	// keep the pages ahead of the read position resident; the window grows with the data read since
+	// the last seek, so that scattered reads (e.g. while probing or scrubbing) don't page in data they skip
+	const uint64 AdviseWindow = FMath::Min(Position - Context->MappedSequentialStart, VlcMediaPlayerSource::MappedReadAhead);
+
+	if ((AdviseWindow > 0) && (Position + AdviseWindow / 2 >= Context->MappedAdvisedEnd))
+	{
+		const uint64 AdviseStart = FMath::Max(Position, Context->MappedAdvisedEnd);
+		const uint64 AdviseEnd = FMath::Min(Position + AdviseWindow, MappedSize);
+
+		if (AdviseEnd > AdviseStart)
+		{
+			VlcMediaPlayerSource::AdviseWillNeed(MappedPtr + AdviseStart, (SIZE_T)(AdviseEnd - AdviseStart));
+		}
+
+		Context->MappedAdvisedEnd = AdviseEnd;
+	}
+
+	FMemory::Memcpy(Buffer, MappedPtr + Position, BytesToRead);
+
+	Context->Position = Position + BytesToRead;
+	Reader->TrackRead(BytesToRead, FPlatformTime::Cycles() - StartCycles);
+
+	return (SSIZE_T)BytesToRead;
+}
+
+
+int FVlcMediaPlayerSource::HandleMappedMediaSeek(void* Opaque, uint64 Offset)
+{
+	auto Context = (FReadContext*)Opaque;
+
+	if (Context == nullptr)
+	{
+		return -1;
+	}
+
+	if ((uint64)Context->Source->MappedRegion->GetMappedSize() <= Offset)
+	{
+		return -1;
+	}
+
+	Context->MappedAdvisedEnd = Offset;
+	Context->MappedSequentialStart = Offset;
+	Context->Position = Offset;
+
+	return 0;
 }
@@ -3,9 +3,20 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/UniquePtr.h"
 
 #include "VlcWrapper.h"
 
+#include <atomic>
+
+class FVlcMediaPlayerPrecache;
+class IMediaOptions;
+class FVlcMediaPlayerReadAhead;
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+
 /**
  * Implements a media source, such as a movie file or URL.
  */
@@ -17,8 +28,13 @@ public:
 	 * Create and initialize a new instance.
 	 *
 	 * @param InInstance The LibVLC instance to use.
+	 * @param InInputOptions VLC input options to add to the media when it is opened.
+	 * @see GetInputOptions
 	 */
-	FVlcMediaPlayerSource(libvlc_instance_t* InVlcInstance);
+	FVlcMediaPlayerSource(libvlc_instance_t* InVlcInstance, const TArray<FString>& InInputOptions = TArray<FString>());
+
+	/** Destructor. */
+	~FVlcMediaPlayerSource();
 
 public:
 
@@ -41,6 +57,38 @@ public:
 	 */
 	FTimespan GetDuration() const;
 
+	/**
+	 * Get the VLC input options that correspond to the specified media options.
+	 *
+	 * The following media options are supported, each overriding the plug-in settings or
+	 * VLC's defaults for one media only:
+	 *   - DiscCaching, FileCaching, LiveCaching, NetworkCaching (int64): Caching duration in milliseconds
+	 *   - DecoderThreads (int64): Number of decoding threads (0 = automatic)
+	 *   - FastDecoding (bool): Whether to allow speed tricks that are not spec compliant
+	 *   - SkipFrames (int64): Frames to skip decoding (-1 = none, 0 = default, 1 = B-frames, 2 = P-frames, 3 = B+P-frames, 4 = all)
+	 *   - SkipLoopFilter (int64): Frames to skip the H.264 loop filter for (0 = none, 1 = non-ref, 2 = bidir, 3 = non-key, 4 = all)
+	 *   - Demux (string): Name of the demux module to use
+	 *   - DemuxFilter (string): Names of the demux filter modules to use
+	 *
+	 * @param Options The media options (optional).
+	 * @return The input options.
+	 */
+	static TArray<FString> GetInputOptions(const IMediaOptions* Options);
+
+	/**
+	 * Get the fraction of a precached file that was loaded into memory.
+	 *
+	 * @return Progress (between 0 and 1, or 1 if the source is not precached).
+	 */
+	float GetPrecacheProgress() const;
+
+	/**
+	 * Get statistics about the data that VLC read from the source.
+	 *
+	 * @return Statistics string.
+	 */
+	FString GetStats() const;
+
 	/**
 	 * Open a media source using the given archive.
 	 *
@@ -52,6 +100,34 @@ public:
 	 */
 	libvlc_media_t* OpenArchive(const TSharedRef<FArchive, ESPMode::ThreadSafe>& Archive, const FString& OriginalUrl);
 
+	/**
+	 * Open a media source by memory mapping a local file.
+	 *
+	 * Reads are served directly from the mapping. This fails for files that cannot be
+	 * mapped, such as compressed or encrypted files in pak files, which must be opened
+	 * as an archive instead.
+	 *
+	 * You must call Close() if this media source is open prior to calling this method.
+	 *
+	 * @param FilePath The path of the file to map.
+	 * @param OriginalUrl The media URL.
+	 * @return The media object, or nullptr if the file couldn't be mapped.
+	 * @see OpenArchive, Close
+	 */
+	libvlc_media_t* OpenMappedFile(const FString& FilePath, const FString& OriginalUrl);
+
+	/**
+	 * Open a media source from a file that is being loaded into memory.
+	 *
+	 * You must call Close() if this media source is open prior to calling this method.
+	 *
+	 * @param InPrecache The precached file.
+	 * @param OriginalUrl The media URL.
+	 * @return The media object.
+	 * @see OpenArchive, Close
+	 */
+	libvlc_media_t* OpenPrecachedFile(const TSharedRef<FVlcMediaPlayerPrecache, ESPMode::ThreadSafe>& InPrecache, const FString& OriginalUrl);
+
 	/**
 	 * Open a media source from the specified URL.
 	 *
@@ -84,14 +160,85 @@ private:
 	/** Handles close callbacks from VLC. */
 	static void HandleMediaClose(void* Opaque);
 
+	/** Handles read callbacks from VLC for mapped files. */
+	static SSIZE_T HandleMappedMediaRead(void* Opaque, unsigned char* Buffer, SIZE_T Length);
+
+	/** Handles seek callbacks from VLC for mapped files. */
+	static int HandleMappedMediaSeek(void* Opaque, uint64 Offset);
+
 private:
 
+	/** State of a single open of the media by VLC. */
+	struct FReadContext
+	{
+		/** End of the mapped range that the OS was last asked to page in (for mapped files only). */
+		uint64 MappedAdvisedEnd = 0;
+
+		/** Position of the last seek (for mapped files only). */
+		uint64 MappedSequentialStart = 0;
+
+		/** Current read position (unless read through the read-ahead). */
+		uint64 Position = 0;
+
+		/** The media source that was opened. */
+		FVlcMediaPlayerSource* Source = nullptr;
+
+		/** Whether the context reads through the source's read-ahead. */
+		bool UsesReadAhead = false;
+	};
+
+	/** Add the input options to the media. */
+	void AddInputOptions();
+
+	/**
+	 * Record a read for the source statistics.
+	 *
+	 * @param Bytes Number of bytes read.
+	 * @param Cycles Number of CPU cycles that the read took.
+	 */
+	void TrackRead(SIZE_T Bytes, uint32 Cycles);
+
+private:
+
+	/** Critical section for synchronizing access to the archive between concurrent opens. */
+	FCriticalSection ArchiveCriticalSection;
+
+	/** Number of bytes that VLC read from the source. */
+	std::atomic<int64> BytesRead;
+
 	/** The file or memory archive to stream from (for local media only). */
 	TSharedPtr<FArchive, ESPMode::ThreadSafe> Data;
 
+	/** VLC input options to add to the media. */
+	TArray<FString> InputOptions;
+
+	/** The memory mapped file (for mapped local files only). */
+	TUniquePtr<IMappedFileHandle> MappedFile;
+
+	/** The mapped region that covers the entire file. */
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
 	/** The media object. */
 	libvlc_media_t* Media;
 
+	/** Number of times that VLC opened the source. */
+	std::atomic<int32> NumOpens;
+
+	/** Number of reads that VLC made. */
+	std::atomic<int32> NumReads;
+
+	/** The precached file that the archive reads from (optional). */
+	TSharedPtr<FVlcMediaPlayerPrecache, ESPMode::ThreadSafe> Precache;
+
+	/** Number of CPU cycles spent reading. */
+	std::atomic<int64> ReadCycles;
+
+	/** Reads the archive ahead of VLC (optional). */
+	TUniquePtr<FVlcMediaPlayerReadAhead> ReadAhead;
+
+	/** Whether an open of the media currently reads through the read-ahead. */
+	std::atomic<bool> ReadAheadInUse;
+
 	/** Currently opened media. */
 	FString CurrentUrl;
 
@@ -3,20 +3,98 @@
 #pragma once
 
 #include "CoreTypes.h"
+#include "Containers/Array.h"
 #include "IMediaTextureSample.h"
-#include "MediaObjectPool.h"
 #include "Math/IntPoint.h"
 #include "Misc/Timespan.h"
 #include "Templates/SharedPointer.h"
 #include <HAL/UnrealMemory.h>
 
 
+/**
+ * Describes the pixel planes of a video buffer.
+ *
+ * All planes are stored back to back in a single allocation, so that
+ * multi-planar formats such as NV12 can be uploaded as one texture.
+ */
+struct FVlcMediaPlayerPlaneLayout
+{
+	/** Maximum number of pixel planes per buffer. */
+	static const uint32 MaxPlanes = 3;
+
+	/** Number of pixel planes in use. */
+	uint32 NumPlanes;
+
+	/** Number of bytes per pixel row for each plane. */
+	uint32 Pitches[MaxPlanes];
+
+	/** Number of pixel rows for each plane. */
+	uint32 Lines[MaxPlanes];
+
+	/** Default constructor. */
+	FVlcMediaPlayerPlaneLayout()
+	{
+		Reset();
+	}
+
+	/**
+	 * Get the total number of bytes required to store all planes.
+	 *
+	 * @return Buffer size (in bytes).
+	 */
+	SIZE_T GetBufferSize() const
+	{
+		return GetPlaneOffset(NumPlanes);
+	}
+
+	/**
+	 * Get the offset of the specified plane from the start of the buffer.
+	 *
+	 * @param Plane The index of the plane.
+	 * @return Plane offset (in bytes).
+	 */
+	SIZE_T GetPlaneOffset(uint32 Plane) const
+	{
+		SIZE_T Offset = 0;
+
+		for (uint32 Index = 0; (Index < Plane) && (Index < NumPlanes); ++Index)
+		{
+			Offset += (SIZE_T)Pitches[Index] * Lines[Index];
+		}
+
+		return Offset;
+	}
+
+	/** Reset the layout to zero planes. */
+	void Reset()
+	{
+		NumPlanes = 0;
+		FMemory::Memzero(Pitches);
+		FMemory::Memzero(Lines);
+	}
+
+	/**
+	 * Set the layout to a single plane.
+	 *
+	 * @param Pitch Number of bytes per pixel row.
+	 * @param NumLines Number of pixel rows.
+	 */
+	void SetSinglePlane(uint32 Pitch, uint32 NumLines)
+	{
+		Reset();
+
+		NumPlanes = 1;
+		Pitches[0] = Pitch;
+		Lines[0] = NumLines;
+	}
+};
+
+
 /**
  * Texture sample generated by VlcMedia player.
  */
 class FVlcMediaPlayerTextureSample
 	: public IMediaTextureSample
-	, public IMediaPoolable
 {
 public:
 
@@ -28,7 +106,6 @@ public:
 		, Duration(FTimespan::Zero())
 		, OutputDim(FIntPoint::ZeroValue)
 		, SampleFormat(EMediaTextureSampleFormat::Undefined)
-		, Stride(0)
 		, Time(FTimespan::Zero())
 	{ }
 
@@ -40,6 +117,16 @@ public:
 
 public:
 
+	/**
+	 * Get the allocated size of the sample buffer.
+	 *
+	 * @return Buffer size (in bytes).
+	 */
+	SIZE_T GetBufferSize() const
+	{
+		return BufferSize;
+	}
+
 	/**
 	 * Get a writable pointer to the sample buffer.
 	 *
@@ -51,13 +138,35 @@ public:
 		return Buffer;
 	}
 
+	/**
+	 * Get a writable pointer to one of the sample's pixel planes.
+	 *
+	 * @param Plane The index of the plane.
+	 * @return The plane's first byte.
+	 * @see GetMutableBuffer, Initialize
+	 */
+	void* GetMutablePlane(uint32 Plane)
+	{
+		return (uint8*)Buffer + Planes.GetPlaneOffset(Plane);
+	}
+
+	/**
+	 * Get the sample's pixel plane layout.
+	 *
+	 * @return Plane layout.
+	 */
+	const FVlcMediaPlayerPlaneLayout& GetPlanes() const
+	{
+		return Planes;
+	}
+
 	/**
 	 * Initialize the sample.
 	 *
 	 * @param InDim The sample buffer's width and height (in pixels).
 	 * @param InOutputDim The sample's output width and height (in pixels).
 	 * @param InSampleFormat The sample format.
-	 * @param InStride Number of bytes per pixel row.
+	 * @param InPlanes The layout of the sample's pixel planes.
 	 * @param InDuration The duration for which the sample is valid.
 	 * @return true on success, false otherwise.
 	 */
@@ -65,7 +174,7 @@ public:
 		const FIntPoint& InDim,
 		const FIntPoint& InOutputDim,
 		EMediaTextureSampleFormat InSampleFormat,
-		uint32 InStride,
+		const FVlcMediaPlayerPlaneLayout& InPlanes,
 		FTimespan InDuration)
 	{
 		if (InSampleFormat == EMediaTextureSampleFormat::Undefined)
@@ -73,7 +182,7 @@ public:
 			return false;
 		}
 
-		const SIZE_T RequiredBufferSize = InStride * InDim.Y;
+		const SIZE_T RequiredBufferSize = InPlanes.GetBufferSize();
 
 		if (RequiredBufferSize == 0)
 		{
@@ -89,12 +198,22 @@ public:
 		Dim = InDim;
 		Duration = InDuration;
 		OutputDim = InOutputDim;
+		Planes = InPlanes;
 		SampleFormat = InSampleFormat;
-		Stride = InStride;
 
 		return true;
 	}
 
+	/**
+	 * Set the duration for which the sample is valid.
+	 *
+	 * @param InDuration The duration to set.
+	 */
+	void SetDuration(FTimespan InDuration)
+	{
+		Duration = InDuration;
+	}
+
 	/**
 	 * Set the time for which the sample was generated.
 	 *
@@ -136,7 +255,7 @@ public:
 
 	virtual uint32 GetStride() const override
 	{
-		return Stride;
+		return Planes.Pitches[0];
 	}
 
 #if WITH_ENGINE
@@ -192,16 +311,133 @@ private:
 	/** Width and height of the output. */
 	FIntPoint OutputDim;
 
+	/** Layout of the pixel planes in the buffer. */
+	FVlcMediaPlayerPlaneLayout Planes;
+
 	/** The sample format. */
 	EMediaTextureSampleFormat SampleFormat;
 
-	/** Number of bytes per pixel row. */
-	uint32 Stride;
-
 	/** Play time for which the sample was generated. */
 	FTimespan Time;
 };
 
 
-/** Implements a pool for VLC texture sample objects. */
-class FVlcMediaTextureSamplePool : public TMediaObjectPool<FVlcMediaPlayerTextureSample> { };
+/**
+ * Implements a pool for VLC texture sample objects.
+ *
+ * The pool holds a shared reference to each of its samples, so that handing a sample
+ * to the sample queue does not allocate a new reference controller for every frame.
+ * A sample is reused once it is neither locked by VLC nor referenced outside the pool.
+ *
+ * VLC locks, displays and unlocks pictures on its video output thread, which is also
+ * the only thread that may call Acquire, Release and ToShared.
+ */
+class FVlcMediaTextureSamplePool
+{
+public:
+
+	/**
+	 * Acquire an unused sample from the pool.
+	 *
+	 * @param MaxSamples Maximum number of samples the pool may own.
+	 * @param OutAllocated Will be set to true if a new sample had to be allocated.
+	 * @return The sample, or nullptr if all samples are in use and the pool is full.
+	 * @see Release, ToShared
+	 */
+	FVlcMediaPlayerTextureSample* Acquire(int32 MaxSamples, bool& OutAllocated)
+	{
+		OutAllocated = false;
+
+		for (FEntry& Entry : Entries)
+		{
+			if (!Entry.Locked && Entry.Sample.IsUnique())
+			{
+				Entry.Locked = true;
+				return &Entry.Sample.Get();
+			}
+		}
+
+		if (Entries.Num() >= MaxSamples)
+		{
+			return nullptr;
+		}
+
+		OutAllocated = true;
+
+		FEntry& Entry = Entries.Add_GetRef(FEntry{ MakeShared<FVlcMediaPlayerTextureSample, ESPMode::ThreadSafe>(), true });
+
+		return &Entry.Sample.Get();
+	}
+
+	/**
+	 * Get the number of samples owned by the pool.
+	 *
+	 * @return Number of samples.
+	 */
+	int32 Num() const
+	{
+		return Entries.Num();
+	}
+
+	/**
+	 * Return an acquired sample to the pool.
+	 *
+	 * The sample will not be reused as long as it is still referenced elsewhere.
+	 *
+	 * @param Sample The sample to release.
+	 * @see Acquire
+	 */
+	void Release(FVlcMediaPlayerTextureSample* Sample)
+	{
+		for (FEntry& Entry : Entries)
+		{
+			if (&Entry.Sample.Get() == Sample)
+			{
+				Entry.Locked = false;
+				break;
+			}
+		}
+	}
+
+	/** Release all samples owned by the pool. */
+	void Reset()
+	{
+		Entries.Empty();
+	}
+
+	/**
+	 * Get a shared reference to an acquired sample.
+	 *
+	 * @param Sample The sample.
+	 * @return Shared reference to the sample.
+	 * @see Acquire
+	 */
+	TSharedRef<FVlcMediaPlayerTextureSample, ESPMode::ThreadSafe> ToShared(FVlcMediaPlayerTextureSample* Sample) const
+	{
+		for (const FEntry& Entry : Entries)
+		{
+			if (&Entry.Sample.Get() == Sample)
+			{
+				return Entry.Sample;
+			}
+		}
+
+		check(false); // sample was not acquired from this pool
+		return Entries[0].Sample;
+	}
+
+private:
+
+	/** A pooled sample. */
+	struct FEntry
+	{
+		/** The sample object. */
+		TSharedRef<FVlcMediaPlayerTextureSample, ESPMode::ThreadSafe> Sample;
+
+		/** Whether VLC is currently decoding into the sample. */
+		bool Locked;
+	};
+
+	/** The pooled samples. */
+	TArray<FEntry> Entries;
+};
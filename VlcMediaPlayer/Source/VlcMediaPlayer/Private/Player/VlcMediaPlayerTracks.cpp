@@ -4,6 +4,8 @@
 #include "VlcMediaPlayerPrivate.h"
 #include "MediaHelpers.h"
 
+#include "VlcMediaPlayerCallbacks.h"
+
 
 #define LOCTEXT_NAMESPACE "FVlcMediaPlayerTracks"
 
@@ -13,12 +15,27 @@
 
 FVlcMediaPlayerTracks::FVlcMediaPlayerTracks()
 	: Player(nullptr)
+	, VideoFrameRate(0.0f)
 { }
 
 
 /* FVlcMediaPlayerTracks interface
 *****************************************************************************/
 
+float FVlcMediaPlayerTracks::GetNominalVideoFrameRate() const
+{
+	const int32 TrackIndex = GetSelectedTrack(EMediaTrackType::Video);
+
+	if (VideoTracks.IsValidIndex(TrackIndex))
+	{
+		return VideoTracks[TrackIndex].FrameRate;
+	}
+
+	// no track is selected before playback starts, and VLC selects the first one by default
+	return (VideoTracks.Num() > 0) ? VideoTracks[0].FrameRate : 0.0f;
+}
+
+
 void FVlcMediaPlayerTracks::Initialize(libvlc_media_player_t& InPlayer, FString& OutInfo)
 {
 	Shutdown();
@@ -27,14 +44,8 @@ void FVlcMediaPlayerTracks::Initialize(libvlc_media_player_t& InPlayer, FString&
 
 	Player = &InPlayer;
 
-	int32 Width = libvlc_video_get_width(Player);
-	int32 Height = libvlc_video_get_height(Player);
 	int32 StreamCount = 0;
 
-	// @todo gmp: fix audio specs
-	libvlc_audio_set_format(Player, "S16N", 44100, 2);
-	libvlc_video_set_format(Player, "RV32", Width, Height, Width * 4);
-
 	// initialize audio tracks
 	libvlc_track_description_t* AudioTrackDescr = libvlc_audio_get_track_description(Player);
 	{
@@ -44,6 +55,7 @@ void FVlcMediaPlayerTracks::Initialize(libvlc_media_player_t& InPlayer, FString&
 			{
 				FTrack Track;
 				{
+					Track.FrameRate = 0.0f;
 					Track.Id = AudioTrackDescr->i_id;
 					Track.Name = ANSI_TO_TCHAR(AudioTrackDescr->psz_name);
 					Track.DisplayName = Track.Name.IsEmpty()
@@ -75,6 +87,7 @@ void FVlcMediaPlayerTracks::Initialize(libvlc_media_player_t& InPlayer, FString&
 			{
 				FTrack Track;
 				{
+					Track.FrameRate = 0.0f;
 					Track.Id = CaptionTrackDescr->i_id;
 					Track.Name = ANSI_TO_TCHAR(CaptionTrackDescr->psz_name);
 					Track.DisplayName = Track.Name.IsEmpty()
@@ -106,6 +119,7 @@ void FVlcMediaPlayerTracks::Initialize(libvlc_media_player_t& InPlayer, FString&
 			{
 				FTrack Track;
 				{
+					Track.FrameRate = 0.0f;
 					Track.Id = VideoTrackDescr->i_id;
 					Track.Name = ANSI_TO_TCHAR(VideoTrackDescr->psz_name);
 					Track.DisplayName = Track.Name.IsEmpty()
@@ -128,10 +142,46 @@ void FVlcMediaPlayerTracks::Initialize(libvlc_media_player_t& InPlayer, FString&
 	}
 	libvlc_track_description_release(VideoTrackDescr);
 
+	// the nominal frame rates are known from parsing, before any frame was decoded
+	libvlc_media_t* Media = libvlc_media_player_get_media(Player);
+
+	if (Media != nullptr)
+	{
+		libvlc_media_track_t** MediaTracks = nullptr;
+		const uint32 NumMediaTracks = libvlc_media_tracks_get(Media, &MediaTracks);
+
+		for (uint32 MediaTrackIndex = 0; MediaTrackIndex < NumMediaTracks; ++MediaTrackIndex)
+		{
+			const libvlc_media_track_t* MediaTrack = MediaTracks[MediaTrackIndex];
+
+			if ((MediaTrack->i_type != libvlc_track_video) || (MediaTrack->video->i_frame_rate_den == 0))
+			{
+				continue;
+			}
+
+			for (FTrack& Track : VideoTracks)
+			{
+				if (Track.Id == MediaTrack->i_id)
+				{
+					Track.FrameRate = (float)MediaTrack->video->i_frame_rate_num / MediaTrack->video->i_frame_rate_den;
+				}
+			}
+		}
+
+		libvlc_media_tracks_release(MediaTracks, NumMediaTracks);
+		libvlc_media_release(Media);
+	}
+
 	UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Tracks %p: Found %i streams"), this, StreamCount);
 }
 
 
+void FVlcMediaPlayerTracks::SetVideoFrameRate(float FrameRate)
+{
+	VideoFrameRate = FrameRate;
+}
+
+
 void FVlcMediaPlayerTracks::Shutdown()
 {
 	UE_LOG(LogVlcMediaPlayer, Verbose, TEXT("Tracks: %p: Shutting down tracks"), this);
@@ -140,6 +190,7 @@ void FVlcMediaPlayerTracks::Shutdown()
 	{
 		AudioTracks.Reset();
 		VideoTracks.Reset();
+		VideoFrameRate = 0.0f;
 		Player = nullptr;
 	}
 }
@@ -150,17 +201,41 @@ void FVlcMediaPlayerTracks::Shutdown()
 
 bool FVlcMediaPlayerTracks::GetAudioTrackFormat(int32 TrackIndex, int32 FormatIndex, FMediaAudioTrackFormat& OutFormat) const
 {
-	if (!AudioTracks.IsValidIndex(TrackIndex) || (FormatIndex != 0))
+	if (!AudioTracks.IsValidIndex(TrackIndex) || (FormatIndex != 0) || (Player == nullptr))
 	{
 		return false;
 	}
 
-	// @todo gmp: fix audio format
-	OutFormat.BitsPerSample = 0;
-	OutFormat.NumChannels = 2;
-	OutFormat.SampleRate = 44100;
+	OutFormat.BitsPerSample = 32;
+	OutFormat.NumChannels = 0;
+	OutFormat.SampleRate = 0;
 	OutFormat.TypeName = TEXT("PCM");
 
+	// audio callbacks receive the track's native rate & channel layout
+	libvlc_media_t* Media = libvlc_media_player_get_media(Player);
+
+	if (Media != nullptr)
+	{
+		libvlc_media_track_t** MediaTracks = nullptr;
+		const uint32 NumMediaTracks = libvlc_media_tracks_get(Media, &MediaTracks);
+
+		for (uint32 MediaTrackIndex = 0; MediaTrackIndex < NumMediaTracks; ++MediaTrackIndex)
+		{
+			const libvlc_media_track_t* MediaTrack = MediaTracks[MediaTrackIndex];
+
+			if ((MediaTrack->i_type == libvlc_track_audio) && (MediaTrack->i_id == AudioTracks[TrackIndex].Id))
+			{
+				OutFormat.NumChannels = FMath::Min(MediaTrack->audio->i_channels, FVlcMediaPlayerCallbacks::MaxAudioChannels);
+				OutFormat.SampleRate = MediaTrack->audio->i_rate;
+
+				break;
+			}
+		}
+
+		libvlc_media_tracks_release(MediaTracks, NumMediaTracks);
+		libvlc_media_release(Media);
+	}
+
 	return true;
 }
 
@@ -320,7 +395,7 @@ bool FVlcMediaPlayerTracks::GetVideoTrackFormat(int32 TrackIndex, int32 FormatIn
 
 	// @todo gmp: fix video specs
 	OutFormat.Dim = FIntPoint(libvlc_video_get_width(Player), libvlc_video_get_height(Player));
-	OutFormat.FrameRate = libvlc_media_player_get_fps(Player);
+	OutFormat.FrameRate = (VideoFrameRate > 0.0f) ? VideoFrameRate : VideoTracks[TrackIndex].FrameRate;
 	OutFormat.FrameRates = TRange<float>(OutFormat.FrameRate);
 	OutFormat.TypeName = TEXT("Default");
 
@@ -19,6 +19,7 @@ class FVlcMediaPlayerTracks
 	struct FTrack
 	{
 		FText DisplayName;
+		float FrameRate;
 		int32 Id;
 		FString Name;
 	}; 
@@ -30,6 +31,13 @@ public:
 
 public:
 
+	/**
+	 * Get the nominal frame rate of the selected video track, as stored in the media.
+	 *
+	 * @return The frame rate (in frames per second), or zero if unknown.
+	 */
+	float GetNominalVideoFrameRate() const;
+
 	/**
 	 * Initialize this object for the specified VLC media player.
 	 *
@@ -38,6 +46,14 @@ public:
 	 */
 	void Initialize(libvlc_media_player_t& InPlayer, FString& OutInfo);
 
+	/**
+	 * Set the measured frame rate of the selected video track.
+	 *
+	 * @param FrameRate The frame rate (in frames per second), or zero if unknown.
+	 * @see GetVideoTrackFormat
+	 */
+	void SetVideoFrameRate(float FrameRate);
+
 	/** Shut down this object. */
 	void Shutdown();
 
@@ -68,6 +84,9 @@ private:
 	/** The VLC media player object. */
 	libvlc_media_player_t* Player;
 
+	/** Measured frame rate of the selected video track (zero if unknown). */
+	float VideoFrameRate;
+
 	/** Video track descriptors. */
 	TArray<FTrack> VideoTracks;
 };
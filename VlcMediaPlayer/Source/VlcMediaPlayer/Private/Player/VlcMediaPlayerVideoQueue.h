@@ -0,0 +1,205 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Containers/Array.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+#include "Templates/SharedPointer.h"
+#include "VlcMediaPlayerSettings.h"
+
+#include "VlcMediaPlayerTextureSample.h"
+
+#include <atomic>
+
+
+/**
+ * Bounded queue for video samples that were displayed by VLC but not yet handed to the player's media samples.
+ *
+ * Samples are added on VLC's video output thread and removed on the game thread.
+ * The storage is allocated up front, so that adding and removing samples never
+ * touches the heap.
+ */
+class FVlcMediaPlayerVideoQueue
+{
+public:
+
+	/** Default constructor. */
+	FVlcMediaPlayerVideoQueue()
+		: Count(0)
+		, Depth(0)
+		, Head(0)
+		, NumDropped(0)
+		, Policy(EVlcMediaPlayerQueuePolicy::DropOldest)
+	{ }
+
+public:
+
+	/**
+	 * Set the queue's capacity and drop policy.
+	 *
+	 * This discards all queued samples and must not be called during playback.
+	 *
+	 * @param InDepth Maximum number of queued samples.
+	 * @param InPolicy What to do with new samples when the queue is full.
+	 */
+	void Configure(int32 InDepth, EVlcMediaPlayerQueuePolicy InPolicy)
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		Depth = (InPolicy == EVlcMediaPlayerQueuePolicy::Mailbox) ? 1 : FMath::Max(InDepth, 1);
+		Policy = InPolicy;
+
+		Samples.Reset();
+		Samples.SetNum(Depth);
+
+		Count = 0;
+		Head = 0;
+		NumDropped = 0;
+	}
+
+	/**
+	 * Remove the oldest sample from the queue.
+	 *
+	 * @param OutSample Will contain the sample.
+	 * @return true if a sample was removed, false if the queue is empty.
+	 */
+	bool Dequeue(TSharedPtr<FVlcMediaPlayerTextureSample, ESPMode::ThreadSafe>& OutSample)
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (Count == 0)
+		{
+			return false;
+		}
+
+		OutSample = MoveTemp(Samples[Head]);
+		Head = (Head + 1) % Depth;
+		--Count;
+
+		return true;
+	}
+
+	/**
+	 * Add a sample to the queue, applying the drop policy if the queue is full.
+	 *
+	 * @param Sample The sample to add.
+	 */
+	void Enqueue(const TSharedRef<FVlcMediaPlayerTextureSample, ESPMode::ThreadSafe>& Sample)
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (Depth == 0)
+		{
+			return;
+		}
+
+		if (Count == Depth)
+		{
+			++NumDropped;
+
+			if (Policy == EVlcMediaPlayerQueuePolicy::DropNewest)
+			{
+				return;
+			}
+
+			// replace oldest sample
+			Samples[Head].Reset();
+			Head = (Head + 1) % Depth;
+			--Count;
+		}
+
+		Samples[(Head + Count) % Depth] = Sample;
+		++Count;
+	}
+
+	/** Discard all queued samples. */
+	void Flush()
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		for (TSharedPtr<FVlcMediaPlayerTextureSample, ESPMode::ThreadSafe>& Sample : Samples)
+		{
+			Sample.Reset();
+		}
+
+		Count = 0;
+		Head = 0;
+	}
+
+	/**
+	 * Get the maximum number of queued samples.
+	 *
+	 * @return Queue depth.
+	 */
+	int32 GetDepth() const
+	{
+		return Depth;
+	}
+
+	/**
+	 * Get the number of samples that were dropped because the queue was full.
+	 *
+	 * @return Number of dropped samples.
+	 */
+	int32 GetNumDropped() const
+	{
+		return NumDropped.load();
+	}
+
+	/**
+	 * Get the policy for handling new samples when the queue is full.
+	 *
+	 * @return Queue policy.
+	 */
+	EVlcMediaPlayerQueuePolicy GetPolicy() const
+	{
+		return Policy;
+	}
+
+	/**
+	 * Check whether a new sample would be dropped by the DropNewest policy.
+	 *
+	 * This allows the caller to skip producing a sample that would be discarded.
+	 * The sample is counted as dropped if the method returns true.
+	 *
+	 * @return true if the new sample is rejected, false otherwise.
+	 */
+	bool RejectNewSample()
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if ((Policy != EVlcMediaPlayerQueuePolicy::DropNewest) || (Count < Depth))
+		{
+			return false;
+		}
+
+		++NumDropped;
+
+		return true;
+	}
+
+private:
+
+	/** Critical section for synchronizing access to the queue. */
+	FCriticalSection CriticalSection;
+
+	/** Number of queued samples. */
+	int32 Count;
+
+	/** Maximum number of queued samples. */
+	int32 Depth;
+
+	/** Index of the oldest queued sample. */
+	int32 Head;
+
+	/** Number of samples dropped because the queue was full. */
+	std::atomic<int32> NumDropped;
+
+	/** What to do with new samples when the queue is full. */
+	EVlcMediaPlayerQueuePolicy Policy;
+
+	/** Ring buffer of queued samples. */
+	TArray<TSharedPtr<FVlcMediaPlayerTextureSample, ESPMode::ThreadSafe>> Samples;
+};
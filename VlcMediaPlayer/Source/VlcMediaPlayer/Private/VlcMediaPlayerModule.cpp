@@ -13,6 +13,7 @@
 
 #include "Interfaces/IPluginManager.h"
 #include "VlcMediaPlayer.h"
+#include "VlcMediaPlayerReaper.h"
 
 #include "VlcWrapper.h"
 #include <string>
@@ -45,6 +46,18 @@ public:
 		return MakeShared<FVlcMediaPlayer, ESPMode::ThreadSafe>(EventSink, VlcInstance);
 	}
 
+	virtual IVlcMediaPlaylist* GetPlaylist(IMediaPlayer& Player) override
+	{
+		static const FName PlayerName(TEXT("VlcMedia"));
+
+		if (Player.GetPlayerName() != PlayerName)
+		{
+			return nullptr;
+		}
+
+		return static_cast<FVlcMediaPlayer*>(&Player);
+	}
+
 public:
 
 	//~ IModuleInterface interface
@@ -80,58 +93,83 @@ public:
 
 		const auto Settings = GetDefault<UVlcMediaPlayerSettings>();
 
-		// create LibVLC instance
-		const ANSICHAR* Args[] =
+		// build LibVLC arguments
+		const TCHAR* HardwareDecoders[] = { TEXT("none"), TEXT("any"), TEXT("d3d11va"), TEXT("dxva2") };
+		const int32 ClockSynchros[] = { -1, 0, 1 };
+
+		TArray<FString> Args =
 		{
 			// caching
-			TCHAR_TO_ANSI(*(FString::Printf(TEXT("--disc-caching=%i"), (int32)Settings->DiscCaching.GetTotalMilliseconds()))),
-			TCHAR_TO_ANSI(*(FString::Printf(TEXT("--file-caching=%i"), (int32)Settings->FileCaching.GetTotalMilliseconds()))),
-			TCHAR_TO_ANSI(*(FString::Printf(TEXT("--live-caching=%i"), (int32)Settings->LiveCaching.GetTotalMilliseconds()))),
-			TCHAR_TO_ANSI(*(FString::Printf(TEXT("--network-caching=%i"), (int32)Settings->NetworkCaching.GetTotalMilliseconds()))),
-
-			"--vout=direct2d",
+			FString::Printf(TEXT("--disc-caching=%i"), (int32)Settings->DiscCaching.GetTotalMilliseconds()),
+			FString::Printf(TEXT("--file-caching=%i"), (int32)Settings->FileCaching.GetTotalMilliseconds()),
+			FString::Printf(TEXT("--live-caching=%i"), (int32)Settings->LiveCaching.GetTotalMilliseconds()),
+			FString::Printf(TEXT("--network-caching=%i"), (int32)Settings->NetworkCaching.GetTotalMilliseconds()),
 
 			// config
-			"--ignore-config",
+			TEXT("--ignore-config"),
+
+			// output
+			TEXT("--aout=amem"),
+			TEXT("--intf=dummy"),
+			TEXT("--text-renderer=dummy"),
+			TEXT("--vout=vmem"),
+
+			// decoding
+			FString::Printf(TEXT("--avcodec-threads=%i"), FMath::Max(0, Settings->DecoderThreads)),
+			FString::Printf(TEXT("--avcodec-hw=%s"), HardwareDecoders[FMath::Min((int32)Settings->HardwareDecoding, (int32)UE_ARRAY_COUNT(HardwareDecoders) - 1)]),
+			Settings->DropLateFrames ? TEXT("--drop-late-frames") : TEXT("--no-drop-late-frames"),
+			Settings->SkipFrames ? TEXT("--skip-frames") : TEXT("--no-skip-frames"),
+
+			// synchronization
+			FString::Printf(TEXT("--clock-jitter=%i"), (int32)Settings->ClockJitter.GetTotalMilliseconds()),
+			FString::Printf(TEXT("--clock-synchro=%i"), ClockSynchros[FMath::Min((int32)Settings->ClockSynchro, (int32)UE_ARRAY_COUNT(ClockSynchros) - 1)]),
+
+			// undesired features
+			TEXT("--no-disable-screensaver"),
+			TEXT("--no-plugins-cache"),
+			TEXT("--no-snapshot-preview"),
+			TEXT("--no-video-title-show"),
+		};
 
-			// logging
+		// logging
 #if UE_BUILD_DEBUG
-			"--file-logging",
-			TCHAR_TO_ANSI(*(FString(TEXT("--logfile=")) + LogFilePath)),
+		Args.Add(TEXT("--file-logging"));
+		Args.Add(TEXT("--logfile=") + FPaths::ConvertRelativePathToFull(FPaths::Combine(FPaths::ProjectLogDir(), TEXT("vlc.log"))));
 #endif
 
 #if (UE_BUILD_DEBUG || UE_BUILD_DEVELOPMENT)
-			"--verbose=2",
+		Args.Add(TEXT("--verbose=2"));
 #else
-			"--quiet",
+		Args.Add(TEXT("--quiet"));
 #endif
 
-			// output
-			"--aout", "amem",
-			"--intf", "dummy",
-			"--text-renderer", "dummy",
-			"--vout", "vmem",
-
-			// performance
-			"--drop-late-frames",
-
-			// undesired features
-			"--no-disable-screensaver",
-			"--no-plugins-cache",
-			"--no-snapshot-preview",
-			"--no-video-title-show",
-
 #if (UE_BUILD_SHIPPING || UE_BUILD_TEST)
-			"--no-stats",
+		Args.Add(TEXT("--no-stats"));
 #endif
 
 #if PLATFORM_LINUX
-			"--no-xlib",
+		Args.Add(TEXT("--no-xlib"));
 #endif
-		};
 
-		int Argc = sizeof(Args) / sizeof(*Args);
-		VlcInstance = libvlc_new(Argc, Args);
+		UE_LOG(LogVlcMediaPlayer, Log, TEXT("Creating VLC instance with arguments: %s"), *FString::Join(Args, TEXT(" ")));
+
+		// LibVLC expects UTF-8 arguments that stay valid until the instance was created
+		TArray<std::string> Utf8Args;
+
+		for (const FString& Arg : Args)
+		{
+			Utf8Args.Emplace(TCHAR_TO_UTF8(*Arg));
+		}
+
+		TArray<const char*> Argv;
+
+		for (const std::string& Utf8Arg : Utf8Args)
+		{
+			Argv.Add(Utf8Arg.c_str());
+		}
+
+		// create LibVLC instance
+		VlcInstance = libvlc_new(Argv.Num(), Argv.GetData());
 
 		if (VlcInstance == nullptr)
 		{
@@ -143,6 +181,9 @@ public:
 
 	virtual void ShutdownModule() override
 	{
+		// stop players that are still being closed
+		FVlcMediaPlayerReaper::Get().Shutdown();
+
 		// unregister logging callback
 		libvlc_log_unset(VlcInstance);
 
@@ -7,6 +7,7 @@
 
 class IMediaEventSink;
 class IMediaPlayer;
+class IVlcMediaPlaylist;
 
 
 /**
@@ -25,6 +26,14 @@ public:
 	 */
 	virtual TSharedPtr<IMediaPlayer, ESPMode::ThreadSafe> CreatePlayer(IMediaEventSink& EventSink) = 0;
 
+	/**
+	 * Get the playlist of a VideoLAN based media player.
+	 *
+	 * @param Player The media player, i.e. the player of a media player facade.
+	 * @return The player's playlist, or nullptr if the player was not created by this module.
+	 */
+	virtual IVlcMediaPlaylist* GetPlaylist(IMediaPlayer& Player) = 0;
+
 public:
 
 	/** Virtual destructor. */
@@ -0,0 +1,50 @@
+// Copyright 2024-2025, obitodaitu. All Rights Reserved.
+
+#pragma once
+
+#include "CoreTypes.h"
+#include "Containers/UnrealString.h"
+
+
+/**
+ * Interface for queuing media on a VideoLAN based media player.
+ *
+ * Queued media is played in order after the currently opened media ends. Each item is
+ * opened in the background shortly before the previous one ends (see the plug-in's
+ * PreloadLeadTime setting), so that playback continues without closing the player.
+ * Queued items are not played while the player is looping, and they are kept when the
+ * player is closed.
+ *
+ * @see IVlcMediaPlayerModule::GetPlaylist
+ */
+class IVlcMediaPlaylist
+{
+public:
+
+	/**
+	 * Append a media URL to the playlist.
+	 *
+	 * @param Url The URL of the media to play after the previously queued media.
+	 */
+	virtual void AddToPlaylist(const FString& Url) = 0;
+
+	/**
+	 * Remove all queued media from the playlist, and discard preloaded media.
+	 *
+	 * If the current media already ended and is waiting for the next item to be opened,
+	 * the player is closed.
+	 */
+	virtual void ClearPlaylist() = 0;
+
+	/**
+	 * Get the number of media items that are waiting to be played.
+	 *
+	 * @return Number of queued items.
+	 */
+	virtual int32 GetPlaylistLength() const = 0;
+
+public:
+
+	/** Virtual destructor. */
+	virtual ~IVlcMediaPlaylist() { }
+};
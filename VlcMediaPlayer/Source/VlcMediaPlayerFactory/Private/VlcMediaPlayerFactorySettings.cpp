@@ -4,8 +4,24 @@
 
 
 UVlcMediaPlayerSettings::UVlcMediaPlayerSettings()
-	: DiscCaching(FTimespan::FromMilliseconds(300.0))
+	: ChunkCacheSize(256)
+	, DiscCaching(FTimespan::FromMilliseconds(300.0))
 	, FileCaching(FTimespan::FromMilliseconds(300.0))
 	, LiveCaching(FTimespan::FromMilliseconds(300.0))
 	, NetworkCaching(FTimespan::FromMilliseconds(1000.0))
+	, ReadAheadBlocks(8)
+	, DecoderThreads(0)
+	, DropLateFrames(true)
+	, HardwareDecoding(EVlcMediaPlayerHardwareDecoding::Off)
+	, SkipFrames(true)
+	, MapLocalFiles(true)
+	, MaxConcurrentOpens(2)
+	, ParseTimeout(FTimespan::FromSeconds(5.0))
+	, PreloadLeadTime(FTimespan::FromSeconds(3.0))
+	, ClockJitter(FTimespan::FromMilliseconds(5000.0))
+	, ClockSynchro(EVlcMediaPlayerClockSynchro::Default)
+	, MaxVideoOutputSize(FIntPoint::ZeroValue)
+	, VideoOutput(EVlcMediaPlayerVideoOutput::Packed)
+	, VideoQueueDepth(4)
+	, VideoQueuePolicy(EVlcMediaPlayerQueuePolicy::DropOldest)
 { }
@@ -26,6 +26,77 @@ enum class EVlcMediaPlayerLogLevel : uint8
 };
 
 
+/**
+ * Available policies for decoding video in hardware.
+ */
+UENUM()
+enum class EVlcMediaPlayerHardwareDecoding : uint8
+{
+	/** Always decode in software. */
+	Off = 0,
+
+	/** Let VLC pick any available hardware decoder. */
+	Automatic = 1,
+
+	/** Use Direct3D 11 video acceleration (Windows only). */
+	D3D11 = 2,
+
+	/** Use DirectX Video Acceleration 2 (Windows only). */
+	Dxva2 = 3,
+};
+
+
+/**
+ * Available modes for synchronizing to the clock of live sources.
+ */
+UENUM()
+enum class EVlcMediaPlayerClockSynchro : uint8
+{
+	/** Use VLC's default for the source. */
+	Default = 0,
+
+	/** Do not synchronize to the source's clock. */
+	Off = 1,
+
+	/** Synchronize to the source's clock. */
+	On = 2,
+};
+
+
+/**
+ * Available pixel layouts for decoded video frames.
+ */
+UENUM()
+enum class EVlcMediaPlayerVideoOutput : uint8
+{
+	/** Planar video is converted to packed YUY2 by VLC on the decoding thread. */
+	Packed = 0,
+
+	/** 4:2:0 video is kept planar and handed to the engine as NV12 for conversion on the GPU. */
+	NativePlanar = 1,
+
+	/** 4:2:0 video is converted to BGRA by the plug-in's SIMD kernels on the decoding thread. */
+	Bgra = 2,
+};
+
+
+/**
+ * Available policies for handling decoded video frames when the sample queue is full.
+ */
+UENUM()
+enum class EVlcMediaPlayerQueuePolicy : uint8
+{
+	/** Discard the oldest queued frame to make room for the new one. */
+	DropOldest = 0,
+
+	/** Discard new frames until the queue has room again. */
+	DropNewest = 1,
+
+	/** Keep only the most recently decoded frame. */
+	Mailbox = 2,
+};
+
+
 /**
  * Settings for the VlcMedia plug-in.
  */
@@ -42,6 +113,16 @@ public:
 
 public:
 
+	/**
+	 * Maximum size of the chunk cache that is shared by all players (in MB, default = 256, 0 = off).
+	 *
+	 * Media read from archives is cached in 1 MB chunks, so that players that open the same
+	 * media at the same time read each chunk from storage only once. Changes take effect
+	 * after restarting the engine.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Caching, meta=(ClampMin=0))
+	int32 ChunkCacheSize;
+
 	/** Caching duration for optical media (default = 300 ms). */
 	UPROPERTY(config, EditAnywhere, Category=Caching)
 	FTimespan DiscCaching;
@@ -57,4 +138,100 @@ public:
 	/** Caching duration for network resources (default = 1000 ms). */
 	UPROPERTY(config, EditAnywhere, Category=Caching)
 	FTimespan NetworkCaching;
+
+	/**
+	 * Number of 1 MB blocks that are read ahead of playback for archive based media (default = 8, 0 = off).
+	 *
+	 * Media read from archives, such as files in pak files, is read on a separate thread,
+	 * so that storage latency does not stall VLC's demuxers.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Caching, meta=(ClampMin=0, ClampMax=64))
+	int32 ReadAheadBlocks;
+
+public:
+
+	/** Number of threads that each video decoder uses (default = 0 = automatic). */
+	UPROPERTY(config, EditAnywhere, Category=Decoding, meta=(ClampMin=0, ClampMax=32))
+	int32 DecoderThreads;
+
+	/** Whether video frames that are decoded too late for display are dropped (default = on). */
+	UPROPERTY(config, EditAnywhere, Category=Decoding)
+	bool DropLateFrames;
+
+	/**
+	 * Whether video is decoded in hardware (default = off).
+	 *
+	 * Decoded frames are copied back to system memory for the engine, which can cost more
+	 * than decoding in software for lower resolutions.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Decoding)
+	EVlcMediaPlayerHardwareDecoding HardwareDecoding;
+
+	/** Whether decoders may skip frames when they fall behind (default = on). */
+	UPROPERTY(config, EditAnywhere, Category=Decoding)
+	bool SkipFrames;
+
+public:
+
+	/**
+	 * Whether local files are read through a memory mapping instead of a file archive (default = on).
+	 *
+	 * Files that cannot be mapped, such as compressed files in pak files, are always read
+	 * through an archive. Files that are precached are loaded into memory instead.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Opening)
+	bool MapLocalFiles;
+
+	/** Maximum number of media sources that are opened in the background at the same time (default = 2). */
+	UPROPERTY(config, EditAnywhere, Category=Opening, meta=(ClampMin=1))
+	int32 MaxConcurrentOpens;
+
+	/** Maximum time that VLC may spend parsing a media source while it is opened (default = 5 s). */
+	UPROPERTY(config, EditAnywhere, Category=Opening)
+	FTimespan ParseTimeout;
+
+public:
+
+	/**
+	 * Time before the end of a playlist item at which the next item is opened (default = 3 s).
+	 *
+	 * The next item is parsed and its first frame decoded in a second, paused player, which
+	 * takes over when the current item ends. Should be longer than opening a media takes.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Playlist)
+	FTimespan PreloadLeadTime;
+
+public:
+
+	/** Largest clock difference that is corrected by resampling instead of resetting the clock (default = 5000 ms). */
+	UPROPERTY(config, EditAnywhere, Category=Synchronization)
+	FTimespan ClockJitter;
+
+	/** Whether playback is synchronized to the clock of live sources (default = VLC's default). */
+	UPROPERTY(config, EditAnywhere, Category=Synchronization)
+	EVlcMediaPlayerClockSynchro ClockSynchro;
+
+public:
+
+	/**
+	 * Maximum size of the decoded video frames (zero = unlimited).
+	 *
+	 * Larger videos are scaled down by VLC before they are handed to the engine, preserving
+	 * their aspect ratio. Can be overridden per player with the 'MaxVideoOutputWidth' and
+	 * 'MaxVideoOutputHeight' media options.
+	 */
+	UPROPERTY(config, EditAnywhere, Category=Video, meta=(ClampMin=0))
+	FIntPoint MaxVideoOutputSize;
+
+	/** Pixel layout of the decoded video frames (can be overridden per player with the 'VideoOutput' media option). */
+	UPROPERTY(config, EditAnywhere, Category=Video)
+	EVlcMediaPlayerVideoOutput VideoOutput;
+
+	/** Maximum number of decoded frames waiting to be consumed (can be overridden per player with the 'VideoQueueDepth' media option). */
+	UPROPERTY(config, EditAnywhere, Category=Video, meta=(ClampMin=1, ClampMax=32))
+	int32 VideoQueueDepth;
+
+	/** What to do with new frames when the queue is full (can be overridden per player with the 'VideoQueuePolicy' media option). */
+	UPROPERTY(config, EditAnywhere, Category=Video)
+	EVlcMediaPlayerQueuePolicy VideoQueuePolicy;
 };